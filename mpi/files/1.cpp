@@ -5,19 +5,23 @@
 #include <ctime>
 #include <algorithm>
 #include <chrono>
+#include <limits>
+#include "shared_input.h"
+#include "file_input.h"
 
 int calc_seq_min(const std::vector<int>& data) {
     return *std::min_element(data.begin(), data.end());
 }
 
-int calc_par_min(const std::vector<int>& data, int local_size, int rank, int size) {
+int calc_par_min(const std::vector<int>& data, int local_size, int rank, int size, long& mem_kb) {
     std::vector<int> local_data(local_size);
 
-    MPI_Scatter(data.data(), local_size, MPI_INT, 
-                local_data.data(), local_size, MPI_INT, 
+    MPI_Scatter(data.data(), local_size, MPI_INT,
+                local_data.data(), local_size, MPI_INT,
                 0, MPI_COMM_WORLD);
 
     int local_min = *std::min_element(local_data.begin(), local_data.end());
+    mem_kb = resident_kb();
 
     int global_min;
     MPI_Reduce(&local_min, &global_min, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
@@ -25,6 +29,58 @@ int calc_par_min(const std::vector<int>& data, int local_size, int rank, int siz
     return global_min;
 }
 
+// Same reduction, but each rank reads its slice in place from the node's
+// shared window instead of receiving a copy.
+int calc_shared_min(SharedInput& input, int local_size, long& mem_kb) {
+    shared_input_distribute(input, local_size);
+
+    const int* local_data = shared_input_slice(input, 0, local_size);
+    int local_min = *std::min_element(local_data, local_data + local_size);
+    mem_kb = resident_kb();
+
+    int global_min;
+    MPI_Reduce(&local_min, &global_min, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+
+    return global_min;
+}
+
+// ./1 <dataset>: each rank reads its own block of row 0 of the file with
+// collective MPI-IO instead of receiving it from rank 0.
+int run_file_input(const char* path, int rank, int size) {
+    FileInput input;
+    if (!file_input_open(path, input, MPI_COMM_WORLD)) {
+        return 1;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto read_start = std::chrono::high_resolution_clock::now();
+    std::vector<int> local_data = file_input_read_block(input, 0, MPI_COMM_WORLD);
+    auto read_end = std::chrono::high_resolution_clock::now();
+    double read_time = std::chrono::duration<double>(read_end - read_start).count();
+    file_input_close(input);
+
+    int local_min = local_data.empty() ? std::numeric_limits<int>::max()
+                                       : *std::min_element(local_data.begin(), local_data.end());
+    int global_min;
+    MPI_Reduce(&local_min, &global_min, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : &read_time, &read_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        long long N = static_cast<long long>(input.header.cols);
+        std::cout << "vec_size,proc_count,read_time,read_GBps,min\n";
+        std::cout << N << "," << size << "," << read_time << ","
+                  << N * sizeof(int) / read_time / 1e9 << "," << global_min << "\n";
+    }
+    return 0;
+}
+
+void fill_random(int* data, int N, unsigned seed) {
+    std::srand(seed);
+    for (int i = 0; i < N; ++i) {
+        data[i] = std::rand() % 1000;
+    }
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
 
@@ -32,46 +88,77 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    if (argc > 1) {
+        int status = run_file_input(argv[1], rank, size);
+        MPI_Finalize();
+        return status;
+    }
+
     std::vector<int> vec_sizes = {1000, 10000, 100000, 1000000, 10000000};
 
     if (rank == 0) {
-        std::cout << "vec_size,proc_count,seq_time,par_time,min\n";
+        std::cout << "vec_size,proc_count,seq_time,par_time,shared_time,par_mem_mb,shared_mem_mb,min,shared_min\n";
     }
 
     for (int N : vec_sizes) {
-        std::vector<int> data;
-        int local_size = N / size; 
+        int local_size = N / size;
+        unsigned seed = static_cast<unsigned>(std::time(0));
 
+        // Memory columns are the growth in resident memory summed over ranks,
+        // sampled while the input and the local slices are live.
         double seq_time = 0.0;
         int seq_min = 0;
-        if (rank == 0) {
-
-            data.resize(N);
-            std::srand(static_cast<unsigned>(std::time(0)));
-            for (int i = 0; i < N; ++i) {
-                data[i] = std::rand() % 1000;
+        int global_min = 0;
+        double par_time = 0.0;
+        long base_kb = resident_kb(), par_kb = 0;
+        {
+            std::vector<int> data;
+            if (rank == 0) {
+
+                data.resize(N);
+                fill_random(data.data(), N, seed);
+
+                auto seq_start = std::chrono::high_resolution_clock::now();
+                seq_min = calc_seq_min(data);
+                auto seq_end = std::chrono::high_resolution_clock::now();
+                seq_time = std::chrono::duration<double>(seq_end - seq_start).count();
             }
 
-            auto seq_start = std::chrono::high_resolution_clock::now();
-            seq_min = calc_seq_min(data);
-            auto seq_end = std::chrono::high_resolution_clock::now();
-            seq_time = std::chrono::duration<double>(seq_end - seq_start).count();
+            auto par_start = std::chrono::high_resolution_clock::now();
+            global_min = calc_par_min(data, local_size, rank, size, par_kb);
+            auto par_end = std::chrono::high_resolution_clock::now();
+            par_time = std::chrono::duration<double>(par_end - par_start).count();
         }
+        long par_delta = par_kb - base_kb, par_total = 0;
+        MPI_Reduce(&par_delta, &par_total, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
-        int global_min = 0;
-        double par_time = 0.0;
+        base_kb = resident_kb();
+        long shared_kb = 0;
+        SharedInput input = shared_input_create(N, local_size, 1, rank);
+        if (rank == 0) {
+            fill_random(shared_input_root_array(input, 0), N, seed);
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto shared_start = std::chrono::high_resolution_clock::now();
+        int shared_min = calc_shared_min(input, local_size, shared_kb);
+        auto shared_end = std::chrono::high_resolution_clock::now();
+        double shared_time = std::chrono::duration<double>(shared_end - shared_start).count();
+        shared_input_free(input);
 
-        auto par_start = std::chrono::high_resolution_clock::now();
-        global_min = calc_par_min(data, local_size, rank, size);
-        auto par_end = std::chrono::high_resolution_clock::now();
-        par_time = std::chrono::duration<double>(par_end - par_start).count();
+        long shared_delta = shared_kb - base_kb, shared_total = 0;
+        MPI_Reduce(&shared_delta, &shared_total, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
         if (rank == 0) {
             std::cout << N << ","
                       << size << ","
                       << seq_time << ","
                       << par_time << ","
-                      << global_min << "\n";
+                      << shared_time << ","
+                      << par_total / 1024.0 << ","
+                      << shared_total / 1024.0 << ","
+                      << global_min << ","
+                      << shared_min << "\n";
         }
     }
 
@@ -2,9 +2,14 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <cstddef>
 #include <vector>
 #include <ctime>
 #include <chrono>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include "buffer_pool.h"
 
 struct Data {
     int id;
@@ -18,38 +23,439 @@ struct Data1 {
     char* name;
 };
 
-void sendWithoutPack(Data1& data, int rank) {
+// C++ type -> MPI basic datatype, for the element types used in our records.
+template <typename T> MPI_Datatype mpi_type_of();
+template <> MPI_Datatype mpi_type_of<char>() { return MPI_CHAR; }
+template <> MPI_Datatype mpi_type_of<int>() { return MPI_INT; }
+template <> MPI_Datatype mpi_type_of<float>() { return MPI_FLOAT; }
+template <> MPI_Datatype mpi_type_of<double>() { return MPI_DOUBLE; }
+template <> MPI_Datatype mpi_type_of<long long>() { return MPI_LONG_LONG; }
+
+// Builds an MPI struct datatype for S from a list of members, e.g.
+//   MPI_Datatype t = StructType<Data>().field(STRUCT_FIELD(Data, id)).field(STRUCT_FIELD(Data, name)).commit();
+// The member pointer gives the field's type and offsetof its displacement, so
+// S must be standard-layout. Array members become one block of their element
+// type; passing count sends only the first count elements. The committed
+// type is resized to sizeof(S), so arrays of S can be sent with count > 1.
+#define STRUCT_FIELD(S, member) &S::member, offsetof(S, member)
+
+template <typename S>
+class StructType {
+    static_assert(std::is_standard_layout<S>::value, "StructType needs a standard-layout record");
+
+public:
+    template <typename F>
+    StructType& field(F S::*, size_t offset, int count = -1) {
+        using Elem = typename std::remove_all_extents<F>::type;
+        block_lengths_.push_back(count >= 0 ? count : static_cast<int>(sizeof(F) / sizeof(Elem)));
+        displacements_.push_back(static_cast<MPI_Aint>(offset));
+        types_.push_back(mpi_type_of<Elem>());
+        return *this;
+    }
+
+    MPI_Datatype commit() const {
+        MPI_Datatype packed, resized;
+        MPI_Type_create_struct(static_cast<int>(types_.size()), block_lengths_.data(),
+                               displacements_.data(), types_.data(), &packed);
+        MPI_Type_create_resized(packed, 0, sizeof(S), &resized);
+        MPI_Type_commit(&resized);
+        MPI_Type_free(&packed);
+        return resized;
+    }
+
+private:
+    std::vector<int> block_lengths_;
+    std::vector<MPI_Aint> displacements_;
+    std::vector<MPI_Datatype> types_;
+};
+
+// Pointer members live outside the object, so each instance needs its own
+// type: the fixed fields (fixed_type at offset 0) plus an hindexed block per
+// payload, placed relative to the object's address. Send and receive from &obj.
+template <typename S, typename Elem>
+MPI_Datatype instance_type(const S& obj, MPI_Datatype fixed_type, const std::vector<const Elem*>& payloads, const std::vector<int>& lengths) {
+    MPI_Aint base;
+    MPI_Get_address(&obj, &base);
+    std::vector<MPI_Aint> payload_displs(payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        MPI_Get_address(payloads[i], &payload_displs[i]);
+        payload_displs[i] = MPI_Aint_diff(payload_displs[i], base);
+    }
+
+    MPI_Datatype payload_type;
+    MPI_Type_create_hindexed(static_cast<int>(payloads.size()), lengths.data(), payload_displs.data(),
+                             mpi_type_of<Elem>(), &payload_type);
+
+    int block_lengths[2] = {1, 1};
+    MPI_Aint displacements[2] = {0, 0};
+    MPI_Datatype types[2] = {fixed_type, payload_type};
+    MPI_Datatype full;
+    MPI_Type_create_struct(2, block_lengths, displacements, types, &full);
+    MPI_Type_commit(&full);
+    MPI_Type_free(&payload_type);
+    return full;
+}
+
+void sendTypedStruct(Data& data, MPI_Datatype data_type, int rank) {
     if (rank == 0) {
-        MPI_Send(&data, sizeof(data), MPI_BYTE, 1, 0, MPI_COMM_WORLD);
+        MPI_Send(&data, 1, data_type, 1, 0, MPI_COMM_WORLD);
     } else if (rank == 1) {
-        MPI_Recv(&data, sizeof(data), MPI_BYTE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(&data, 1, data_type, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
     }
 }
 
-void sendWithPack(Data& data, int rank, int dataSize) {
-    int bufferSize;
-    MPI_Pack_size(1, MPI_INT, MPI_COMM_WORLD, &bufferSize);
-    MPI_Pack_size(1, MPI_FLOAT, MPI_COMM_WORLD, &bufferSize);
-    MPI_Pack_size(dataSize, MPI_CHAR, MPI_COMM_WORLD, &bufferSize);
+void sendTypedPointer(Data1& data, MPI_Datatype header_type, int rank, int dataSize) {
+    if (rank > 1) {
+        return;
+    }
+    MPI_Datatype full = instance_type<Data1, char>(data, header_type, {data.name}, {dataSize});
+    if (rank == 0) {
+        MPI_Send(&data, 1, full, 1, 0, MPI_COMM_WORLD);
+    } else {
+        MPI_Recv(&data, 1, full, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    MPI_Type_free(&full);
+}
+
+void sendWithPack(Data1& data, int rank, int dataSize) {
+    int idSize, valSize, nameSize;
+    MPI_Pack_size(1, MPI_INT, MPI_COMM_WORLD, &idSize);
+    MPI_Pack_size(1, MPI_FLOAT, MPI_COMM_WORLD, &valSize);
+    MPI_Pack_size(dataSize, MPI_CHAR, MPI_COMM_WORLD, &nameSize);
 
-    int totalBufferSize = bufferSize * 3;
-    char* buffer = new char[totalBufferSize];
+    int totalBufferSize = idSize + valSize + nameSize;
+    BufferLease buffer = buffer_pool().acquire(totalBufferSize);
 
     if (rank == 0) {
         int pos = 0;
-        MPI_Pack(&data.id, 1, MPI_INT, buffer, totalBufferSize, &pos, MPI_COMM_WORLD);
-        MPI_Pack(&data.val, 1, MPI_FLOAT, buffer, totalBufferSize, &pos, MPI_COMM_WORLD);
-        MPI_Pack(&data.name, dataSize, MPI_CHAR, buffer, totalBufferSize, &pos, MPI_COMM_WORLD);
-        MPI_Send(buffer, totalBufferSize, MPI_BYTE, 1, 1, MPI_COMM_WORLD);
+        MPI_Pack(&data.id, 1, MPI_INT, buffer.data(), totalBufferSize, &pos, MPI_COMM_WORLD);
+        MPI_Pack(&data.val, 1, MPI_FLOAT, buffer.data(), totalBufferSize, &pos, MPI_COMM_WORLD);
+        MPI_Pack(data.name, dataSize, MPI_CHAR, buffer.data(), totalBufferSize, &pos, MPI_COMM_WORLD);
+        MPI_Send(buffer.data(), pos, MPI_PACKED, 1, 1, MPI_COMM_WORLD);
     } else if (rank == 1) {
-        MPI_Recv(buffer, totalBufferSize, MPI_BYTE, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(buffer.data(), totalBufferSize, MPI_PACKED, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         int pos = 0;
-        MPI_Unpack(buffer, totalBufferSize, &pos, &data.id, 1, MPI_INT, MPI_COMM_WORLD);
-        MPI_Unpack(buffer, totalBufferSize, &pos, &data.val, 1, MPI_FLOAT, MPI_COMM_WORLD);
-        MPI_Unpack(buffer, totalBufferSize, &pos, &data.name, dataSize, MPI_CHAR, MPI_COMM_WORLD);
+        MPI_Unpack(buffer.data(), totalBufferSize, &pos, &data.id, 1, MPI_INT, MPI_COMM_WORLD);
+        MPI_Unpack(buffer.data(), totalBufferSize, &pos, &data.val, 1, MPI_FLOAT, MPI_COMM_WORLD);
+        MPI_Unpack(buffer.data(), totalBufferSize, &pos, data.name, dataSize, MPI_CHAR, MPI_COMM_WORLD);
+    }
+}
+
+void sendWithMemcpy(Data1& data, int rank, int dataSize) {
+    size_t totalBufferSize = sizeof(data.id) + sizeof(data.val) + dataSize;
+    BufferLease buffer = buffer_pool().acquire(totalBufferSize);
+
+    if (rank == 0) {
+        char* pos = buffer.data();
+        std::memcpy(pos, &data.id, sizeof(data.id));
+        pos += sizeof(data.id);
+        std::memcpy(pos, &data.val, sizeof(data.val));
+        pos += sizeof(data.val);
+        std::memcpy(pos, data.name, dataSize);
+        MPI_Send(buffer.data(), static_cast<int>(totalBufferSize), MPI_BYTE, 1, 2, MPI_COMM_WORLD);
+    } else if (rank == 1) {
+        MPI_Recv(buffer.data(), static_cast<int>(totalBufferSize), MPI_BYTE, 0, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        const char* pos = buffer.data();
+        std::memcpy(&data.id, pos, sizeof(data.id));
+        pos += sizeof(data.id);
+        std::memcpy(&data.val, pos, sizeof(data.val));
+        pos += sizeof(data.val);
+        std::memcpy(data.name, pos, dataSize);
+    }
+}
+
+// Streaming transfer for large records: a small header with the real payload
+// length goes first, then the payload moves straight from/to the record in
+// chunk_size pieces with at most max_in_flight Isend/Irecv requests pending.
+// Nothing is staged, so memory use does not grow with the record size.
+struct StreamHeader {
+    int id;
+    float val;
+    long long length;
+};
+
+struct StreamConfig {
+    int chunk_size;
+    int max_in_flight;
+    MPI_Datatype header_type;
+};
+
+void streamPayload(char* payload, long long length, int peer, bool sending, const StreamConfig& cfg) {
+    std::vector<MPI_Request> window(cfg.max_in_flight, MPI_REQUEST_NULL);
+    long long n_chunks = (length + cfg.chunk_size - 1) / cfg.chunk_size;
+
+    for (long long k = 0; k < n_chunks; ++k) {
+        MPI_Request& slot = window[k % cfg.max_in_flight];
+        MPI_Wait(&slot, MPI_STATUS_IGNORE);
+
+        long long offset = k * cfg.chunk_size;
+        int count = static_cast<int>(std::min<long long>(cfg.chunk_size, length - offset));
+        if (sending) {
+            MPI_Isend(payload + offset, count, MPI_CHAR, peer, 4, MPI_COMM_WORLD, &slot);
+        } else {
+            MPI_Irecv(payload + offset, count, MPI_CHAR, peer, 4, MPI_COMM_WORLD, &slot);
+        }
+    }
+    MPI_Waitall(cfg.max_in_flight, window.data(), MPI_STATUSES_IGNORE);
+}
+
+// The receiver streams into data.name, which must hold capacity bytes; a
+// longer record aborts instead of overrunning it.
+void sendStreamed(Data1& data, int rank, int dataSize, long long capacity, const StreamConfig& cfg) {
+    StreamHeader header;
+    if (rank == 0) {
+        header = {data.id, data.val, dataSize};
+        MPI_Send(&header, 1, cfg.header_type, 1, 3, MPI_COMM_WORLD);
+        streamPayload(data.name, header.length, 1, true, cfg);
+    } else if (rank == 1) {
+        MPI_Recv(&header, 1, cfg.header_type, 0, 3, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (header.length > capacity) {
+            std::cerr << "Streamed record of " << header.length << " bytes does not fit in " << capacity << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        data.id = header.id;
+        data.val = header.val;
+        streamPayload(data.name, header.length, 0, false, cfg);
+    }
+}
+
+// Optional compression on the send path. A PackBits-style run-length codec:
+// control byte c < 128 is followed by c + 1 literal bytes, c >= 128 repeats the
+// next byte c - 125 times (3..130). Incompressible data grows by at most 1/128.
+enum Codec {
+    CODEC_RAW = 0,
+    CODEC_RLE = 1,
+    CODEC_AUTO = -1
+};
+
+size_t rleEncode(const char* in, size_t length, char* out) {
+    size_t pos = 0, i = 0;
+    while (i < length) {
+        size_t run = 1;
+        while (i + run < length && run < 130 && in[i + run] == in[i]) {
+            ++run;
+        }
+        if (run >= 3) {
+            out[pos++] = static_cast<char>(run + 125);
+            out[pos++] = in[i];
+            i += run;
+            continue;
+        }
+
+        size_t start = i;
+        size_t literals = 0;
+        while (i < length && literals < 128) {
+            if (i + 2 < length && in[i] == in[i + 1] && in[i] == in[i + 2]) {
+                break;
+            }
+            ++i;
+            ++literals;
+        }
+        out[pos++] = static_cast<char>(literals - 1);
+        std::memcpy(out + pos, in + start, literals);
+        pos += literals;
+    }
+    return pos;
+}
+
+size_t rleBound(size_t length) {
+    return length + length / 128 + 1;
+}
+
+void rleDecode(const char* in, size_t length, char* out) {
+    size_t pos = 0, i = 0;
+    while (i < length) {
+        unsigned char control = static_cast<unsigned char>(in[i++]);
+        if (control < 128) {
+            std::memcpy(out + pos, in + i, control + 1);
+            pos += control + 1;
+            i += control + 1;
+        } else {
+            std::memset(out + pos, in[i++], control - 125);
+            pos += control - 125;
+        }
+    }
+}
+
+struct CompressionHeader {
+    int codec;
+    int raw_length;
+    int wire_length;
+};
+
+// Rates the send path decides with: link bandwidth from a ping-pong between
+// ranks 0 and 1 (the real link, so decisions match the measured times),
+// codec throughput from encoding/decoding a mixed buffer. All in bytes per
+// second; every rank holds the same values.
+struct AdaptiveLink {
+    double link_rate;
+    double encode_rate;
+    double decode_rate;
+    int sample_bytes;
+    MPI_Datatype header_type;
+};
+
+AdaptiveLink calibrateLink(int rank) {
+    AdaptiveLink link = {0.0, 0.0, 0.0, 4096,
+                         StructType<CompressionHeader>().field(STRUCT_FIELD(CompressionHeader, codec))
+                             .field(STRUCT_FIELD(CompressionHeader, raw_length)).field(STRUCT_FIELD(CompressionHeader, wire_length)).commit()};
+    const int probe = 1 << 20;
+    const int reps = 5;
+    std::vector<char> buf(probe);
+    for (int i = 0; i < probe; ++i) {
+        buf[i] = (i / 512) % 2 ? static_cast<char>(i * 7919 >> 3) : 'A';
     }
 
-    delete[] buffer;
+    double rates[3] = {0.0, 0.0, 0.0};
+    if (rank == 0) {
+        std::vector<char> encoded(rleBound(probe)), decoded(probe);
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t encoded_size = 0;
+        for (int r = 0; r < reps; ++r) {
+            encoded_size = rleEncode(buf.data(), probe, encoded.data());
+        }
+        auto mid = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < reps; ++r) {
+            rleDecode(encoded.data(), encoded_size, decoded.data());
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        rates[1] = reps * probe / std::chrono::duration<double>(mid - start).count();
+        rates[2] = reps * probe / std::chrono::duration<double>(end - mid).count();
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        if (rank == 0) {
+            MPI_Send(buf.data(), probe, MPI_CHAR, 1, 7, MPI_COMM_WORLD);
+            MPI_Recv(buf.data(), probe, MPI_CHAR, 1, 7, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        } else if (rank == 1) {
+            MPI_Recv(buf.data(), probe, MPI_CHAR, 0, 7, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(buf.data(), probe, MPI_CHAR, 0, 7, MPI_COMM_WORLD);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    if (rank == 0) {
+        rates[0] = 2.0 * reps * probe / std::chrono::duration<double>(end - start).count();
+    }
+
+    MPI_Bcast(rates, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    link.link_rate = rates[0];
+    link.encode_rate = rates[1];
+    link.decode_rate = rates[2];
+    return link;
+}
+
+// Compresses up to four evenly spaced slices of the payload (sample_bytes in
+// total) and returns compressed/raw for them.
+double sampleRatio(const char* payload, int length, const AdaptiveLink& link, std::vector<char>& scratch) {
+    int slices = 4;
+    int slice = std::max(1, std::min(length, link.sample_bytes) / slices);
+    scratch.resize(std::max(scratch.size(), rleBound(slice)));
+    size_t raw = 0, encoded = 0;
+    for (int s = 0; s < slices; ++s) {
+        int offset = static_cast<int>(static_cast<long long>(length - slice) * s / std::max(1, slices - 1));
+        if (offset < 0 || offset + slice > length) {
+            continue;
+        }
+        raw += slice;
+        encoded += rleEncode(payload + offset, slice, scratch.data());
+    }
+    return raw > 0 ? static_cast<double>(encoded) / raw : 1.0;
+}
+
+// Raw send time against encode + smaller send + decode, from the sampled ratio.
+Codec chooseCodec(const char* payload, int length, const AdaptiveLink& link, std::vector<char>& scratch) {
+    double ratio = sampleRatio(payload, length, link, scratch);
+    double raw_time = length / link.link_rate;
+    double rle_time = length / link.encode_rate + ratio * length / link.link_rate + length / link.decode_rate;
+    return rle_time < raw_time ? CODEC_RLE : CODEC_RAW;
+}
+
+// Sends the header, then either the payload itself or its RLE form from
+// scratch. scratch is owned by the caller and kept across calls.
+Codec sendAdaptive(const char* payload, int length, int dest, Codec codec, const AdaptiveLink& link, std::vector<char>& scratch) {
+    if (codec == CODEC_AUTO) {
+        codec = chooseCodec(payload, length, link, scratch);
+    }
+
+    CompressionHeader header = {codec, length, length};
+    const char* wire = payload;
+    if (codec == CODEC_RLE) {
+        scratch.resize(std::max(scratch.size(), rleBound(length)));
+        header.wire_length = static_cast<int>(rleEncode(payload, length, scratch.data()));
+        wire = scratch.data();
+    }
+    MPI_Send(&header, 1, link.header_type, dest, 5, MPI_COMM_WORLD);
+    MPI_Send(wire, header.wire_length, MPI_CHAR, dest, 6, MPI_COMM_WORLD);
+    return codec;
+}
+
+int recvAdaptive(char* payload, int capacity, int source, const AdaptiveLink& link, std::vector<char>& scratch) {
+    CompressionHeader header;
+    MPI_Recv(&header, 1, link.header_type, source, 5, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (header.raw_length > capacity) {
+        std::cerr << "Compressed record of " << header.raw_length << " bytes does not fit in " << capacity << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (header.codec == CODEC_RAW) {
+        MPI_Recv(payload, header.wire_length, MPI_CHAR, source, 6, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    } else {
+        scratch.resize(std::max(scratch.size(), static_cast<size_t>(header.wire_length)));
+        MPI_Recv(scratch.data(), header.wire_length, MPI_CHAR, source, 6, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        rleDecode(scratch.data(), header.wire_length, payload);
+    }
+    return header.raw_length;
+}
+
+Codec sendCompressed(Data1& data, int rank, int dataSize, long long capacity, Codec codec,
+                     const AdaptiveLink& link, std::vector<char>& scratch) {
+    if (rank == 0) {
+        return sendAdaptive(data.name, dataSize, 1, codec, link, scratch);
+    } else if (rank == 1) {
+        recvAdaptive(data.name, static_cast<int>(capacity), 0, link, scratch);
+    }
+    return codec;
+}
+
+bool checkReceived(int id, float val, const char* name, int dataSize) {
+    if (id != 123 || val != 456.789f) {
+        return false;
+    }
+    for (int i = 0; i < dataSize; ++i) {
+        if (name[i] != 'A') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Times num_runs transfers and returns the time per transfer on the slower of
+// sender and receiver, so unpacking or decoding on rank 1 is counted. Rank 1
+// clears its copy first and checks the last one it received; every rank
+// learns whether that check passed.
+template <typename Transfer, typename Reset, typename Check>
+double timeTransfer(Transfer transfer, Reset reset, Check check, int rank, int num_runs, bool& correct) {
+    if (rank == 1) {
+        reset();
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_runs; ++i) {
+        transfer();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    int ok = rank == 1 ? check() : 1;
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    correct = correct && all_ok;
+
+    double local = std::chrono::duration<double>(end - start).count() / num_runs;
+    double slowest = 0.0;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return slowest;
 }
 
 int main(int argc, char** argv) {
@@ -59,44 +465,98 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    std::vector<int> sizes = {10, 100, 1000, 10000, 100000, 1000000};
+    std::vector<int> sizes = {10, 100, 1000, 10000, 100000, 1000000, 4000000, 16000000};
+    const int num_runs = 10;
+    const int max_size = *std::max_element(sizes.begin(), sizes.end());
+
+    MPI_Datatype data1_header = StructType<Data1>().field(STRUCT_FIELD(Data1, id)).field(STRUCT_FIELD(Data1, val)).commit();
+    StreamConfig stream_cfg = {256 * 1024, 4,
+                               StructType<StreamHeader>().field(STRUCT_FIELD(StreamHeader, id)).field(STRUCT_FIELD(StreamHeader, val))
+                                   .field(STRUCT_FIELD(StreamHeader, length)).commit()};
+
+    AdaptiveLink link = calibrateLink(rank);
+    std::vector<char> compress_scratch;
+
+    // Both records live on the heap for the whole run; Data alone is ~1MB.
+    std::unique_ptr<Data> data(new Data);
+    std::vector<char> name_storage(max_size + 1);
+    Data1 data1;
+    data1.name = name_storage.data();
 
     if (rank == 0) {
-        std::cout << "data_size,without_pack_time,with_pack_time" << std::endl;
+        std::cout << "# link " << link.link_rate / 1e6 << " MB/s, rle encode " << link.encode_rate / 1e6
+                  << " MB/s, rle decode " << link.decode_rate / 1e6 << " MB/s" << std::endl;
+        std::cout << "data_size,typed_struct_time,typed_pointer_time,pack_time,memcpy_time,streamed_time,streamed_MBps,"
+                  << "raw_send_time,rle_send_time,adaptive_time,adaptive_codec,correct" << std::endl;
     }
 
     for (int dataSize : sizes) {
-        Data data;
-        Data1 data1;
-        data1.name = new char[dataSize + 1];
+        bool fitsData = dataSize < static_cast<int>(sizeof(data->name));
 
-        data.id = 123;
-        data.val = 456.789f;
-        std::memset(data.name, 'A', dataSize);
-        data.name[dataSize] = '\0';
+        data->id = 123;
+        data->val = 456.789f;
+        if (fitsData) {
+            std::memset(data->name, 'A', dataSize);
+            data->name[dataSize] = '\0';
+        }
 
         data1.id = 123;
         data1.val = 456.789f;
         std::memset(data1.name, 'A', dataSize);
         data1.name[dataSize] = '\0';
 
-        auto start1 = std::chrono::high_resolution_clock::now();
-        sendWithoutPack(data1, rank);
-        auto end1 = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> duration1 = end1 - start1;
+        auto resetData = [&] { data->id = 0; data->val = 0.0f; std::memset(data->name, 0, dataSize); };
+        auto resetData1 = [&] { data1.id = 0; data1.val = 0.0f; std::memset(data1.name, 0, dataSize); };
+        auto checkData = [&] { return checkReceived(data->id, data->val, data->name, dataSize); };
+        auto checkData1 = [&] { return checkReceived(data1.id, data1.val, data1.name, dataSize); };
+        auto resetName1 = [&] { std::memset(data1.name, 0, dataSize); };
+        auto checkName1 = [&] { return checkReceived(123, 456.789f, data1.name, dataSize); };
 
-        auto start2 = std::chrono::high_resolution_clock::now();
-        sendWithPack(data, rank, dataSize);
-        auto end2 = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> duration2 = end2 - start2;
+        bool correct = true;
+        double structTime = 0.0;
+        if (fitsData) {
+            // Only the first dataSize bytes of name, like every other column.
+            MPI_Datatype data_type = StructType<Data>().field(STRUCT_FIELD(Data, id)).field(STRUCT_FIELD(Data, val))
+                                         .field(STRUCT_FIELD(Data, name), dataSize).commit();
+            structTime = timeTransfer([&] { sendTypedStruct(*data, data_type, rank); },
+                                      resetData, checkData, rank, num_runs, correct);
+                }
+        double pointerTime = timeTransfer([&] { sendTypedPointer(data1, data1_header, rank, dataSize); },
+                                          resetData1, checkData1, rank, num_runs, correct);
+        double packTime = timeTransfer([&] { sendWithPack(data1, rank, dataSize); },
+                                       resetData1, checkData1, rank, num_runs, correct);
+        double memcpyTime = timeTransfer([&] { sendWithMemcpy(data1, rank, dataSize); },
+                                         resetData1, checkData1, rank, num_runs, correct);
+        double streamTime = timeTransfer([&] { sendStreamed(data1, rank, dataSize, max_size, stream_cfg); },
+                                         resetData1, checkData1, rank, num_runs, correct);
+        double rawTime = timeTransfer([&] { sendCompressed(data1, rank, dataSize, max_size, CODEC_RAW, link, compress_scratch); },
+                                      resetName1, checkName1, rank, num_runs, correct);
+        double rleTime = timeTransfer([&] { sendCompressed(data1, rank, dataSize, max_size, CODEC_RLE, link, compress_scratch); },
+                                      resetName1, checkName1, rank, num_runs, correct);
+        Codec chosen = CODEC_AUTO;
+        double adaptiveTime = timeTransfer([&] { chosen = sendCompressed(data1, rank, dataSize, max_size, CODEC_AUTO, link, compress_scratch); },
+                                           resetName1, checkName1, rank, num_runs, correct);
 
         if (rank == 0) {
-            std::cout << dataSize << "," << duration1.count() << "," << duration2.count() << std::endl;
+            std::cout << dataSize << ",";
+            if (fitsData) {
+                std::cout << structTime;
+            } else {
+                std::cout << "n/a";
+            }
+            std::cout << "," << pointerTime << "," << packTime << "," << memcpyTime << ","
+                      << streamTime << "," << dataSize / streamTime / 1e6 << ","
+                      << rawTime << "," << rleTime << "," << adaptiveTime << ","
+                      << (chosen == CODEC_RLE ? "rle" : "raw") << ","
+                      << (correct ? "Yes" : "No") << std::endl;
         }
-
-        delete[] data1.name;
     }
 
+    MPI_Type_free(&data1_header);
+    MPI_Type_free(&stream_cfg.header_type);
+    MPI_Type_free(&link.header_type);
+
+    buffer_pool().clear();
     MPI_Finalize();
     return 0;
 }
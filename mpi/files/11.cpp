@@ -1,11 +1,12 @@
 #include <mpi.h>
 #include <iostream>
+#include <vector>
+#include <string>
 #include <chrono>
-#include <cmath>
 
-void all_reduce(int rank, int& global_sum) {
+void all_reduce(int rank, MPI_Comm grid_comm, int& global_sum) {
     int value = rank;
-    MPI_Reduce(&value, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&value, &global_sum, 1, MPI_INT, MPI_SUM, 0, grid_comm);
 }
 
 void row_reduce(int rank, MPI_Comm row_comm, int& row_sum) {
@@ -18,59 +19,266 @@ void col_reduce(int rank, MPI_Comm col_comm, int& col_sum) {
     MPI_Reduce(&value, &col_sum, 1, MPI_INT, MPI_SUM, 0, col_comm);
 }
 
+void dim_allreduce(int rank, MPI_Comm comm, int& sum) {
+    int value = rank;
+    MPI_Allreduce(&value, &sum, 1, MPI_INT, MPI_SUM, comm);
+}
+
+void dim_bcast(int rank, MPI_Comm comm, int& value) {
+    value = rank;
+    MPI_Bcast(&value, 1, MPI_INT, 0, comm);
+}
+
+// A reduce, allreduce or bcast of one MPI_INT (sum, root 0) set up once and
+// then run any number of times. With MPI-4 it wraps MPI_Reduce_init /
+// MPI_Allreduce_init / MPI_Bcast_init; older libraries get a binomial-tree
+// schedule of persistent point-to-point requests built here instead. The
+// buffers passed to persistent_init must stay put until persistent_free.
+enum CollKind { COLL_REDUCE, COLL_ALLREDUCE, COLL_BCAST };
+
+struct PersistentColl {
+    CollKind kind;
+    bool root;
+    int* send;
+    int* result;
+    MPI_Request req;
+    std::vector<MPI_Request> from_children;
+    std::vector<MPI_Request> to_children;
+    MPI_Request to_parent;
+    MPI_Request from_parent;
+    std::vector<int> partials;  // one slot per child, then the running sum
+};
+
+const char* persistent_backend() {
+#if MPI_VERSION >= 4
+    return "mpi4";
+#else
+    return "p2p";
+#endif
+}
+
+PersistentColl persistent_init(CollKind kind, int* send, int* result, MPI_Comm comm) {
+    PersistentColl pc;
+    pc.kind = kind;
+    pc.root = false;
+    pc.send = send;
+    pc.result = result;
+    pc.req = MPI_REQUEST_NULL;
+    pc.to_parent = MPI_REQUEST_NULL;
+    pc.from_parent = MPI_REQUEST_NULL;
+#if MPI_VERSION >= 4
+    if (kind == COLL_REDUCE) {
+        MPI_Reduce_init(send, result, 1, MPI_INT, MPI_SUM, 0, comm, MPI_INFO_NULL, &pc.req);
+    } else if (kind == COLL_ALLREDUCE) {
+        MPI_Allreduce_init(send, result, 1, MPI_INT, MPI_SUM, comm, MPI_INFO_NULL, &pc.req);
+    } else {
+        MPI_Bcast_init(result, 1, MPI_INT, 0, comm, MPI_INFO_NULL, &pc.req);
+    }
+#else
+    int rank, n;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &n);
+
+    // Children of r are r + mask for every mask below r's lowest set bit.
+    int low = rank == 0 ? n : (rank & -rank);
+    std::vector<int> children;
+    for (int mask = 1; mask < low && rank + mask < n; mask <<= 1) {
+        children.push_back(rank + mask);
+    }
+    pc.root = rank == 0;
+    int parent = pc.root ? MPI_PROC_NULL : rank - low;
+    int nc = static_cast<int>(children.size());
+    pc.partials.assign(nc + 1, 0);
+    int* sum = &pc.partials[nc];
+
+    if (kind != COLL_BCAST) {
+        pc.from_children.resize(nc);
+        for (int c = 0; c < nc; ++c) {
+            MPI_Recv_init(&pc.partials[c], 1, MPI_INT, children[c], 0, comm, &pc.from_children[c]);
+        }
+        MPI_Send_init(sum, 1, MPI_INT, parent, 0, comm, &pc.to_parent);
+    }
+    if (kind != COLL_REDUCE) {
+        MPI_Recv_init(result, 1, MPI_INT, parent, 1, comm, &pc.from_parent);
+        pc.to_children.resize(nc);
+        for (int c = 0; c < nc; ++c) {
+            MPI_Send_init(result, 1, MPI_INT, children[c], 1, comm, &pc.to_children[c]);
+        }
+    }
+#endif
+    return pc;
+}
+
+void persistent_run(PersistentColl& pc) {
+#if MPI_VERSION >= 4
+    MPI_Start(&pc.req);
+    MPI_Wait(&pc.req, MPI_STATUS_IGNORE);
+#else
+    int nc = static_cast<int>(pc.partials.size()) - 1;
+    if (pc.kind != COLL_BCAST) {
+        // Receives from every child are posted before any of them is needed.
+        int& sum = pc.partials[nc];
+        if (nc > 0) {
+            MPI_Startall(nc, pc.from_children.data());
+        }
+        sum = *pc.send;
+        for (int c = 0; c < nc; ++c) {
+            MPI_Wait(&pc.from_children[c], MPI_STATUS_IGNORE);
+            MPI_Reduce_local(&pc.partials[c], &sum, 1, MPI_INT, MPI_SUM);
+        }
+        MPI_Start(&pc.to_parent);
+        MPI_Wait(&pc.to_parent, MPI_STATUS_IGNORE);
+        if (pc.root) {
+            *pc.result = sum;
+        }
+    }
+    if (pc.kind != COLL_REDUCE) {
+        MPI_Start(&pc.from_parent);
+        MPI_Wait(&pc.from_parent, MPI_STATUS_IGNORE);
+        if (nc > 0) {
+            MPI_Startall(nc, pc.to_children.data());
+            MPI_Waitall(nc, pc.to_children.data(), MPI_STATUSES_IGNORE);
+        }
+    }
+#endif
+}
+
+void persistent_free(PersistentColl& pc) {
+    auto release = [](MPI_Request& r) {
+        if (r != MPI_REQUEST_NULL) {
+            MPI_Request_free(&r);
+        }
+    };
+    release(pc.req);
+    release(pc.to_parent);
+    release(pc.from_parent);
+    for (auto& r : pc.from_children) {
+        release(r);
+    }
+    for (auto& r : pc.to_children) {
+        release(r);
+    }
+}
+
+// Average time per call on the slowest rank, measured from a common start.
+template <typename Op>
+double average_time(Op op, int num_meas) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_meas; ++i) {
+        op();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double local = std::chrono::duration<double>(end_time - start_time).count() / num_meas;
+    double slowest = 0.0;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return slowest;
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
 
-    int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int world_rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    int grid_size = static_cast<int>(sqrt(size));
-    int row = rank / grid_size;
-    int col = rank % grid_size;
+    // P x Q grid for any process count; reorder lets MPI place neighbours well.
+    int dims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    MPI_Dims_create(size, 2, dims);
+
+    MPI_Comm grid_comm;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &grid_comm);
+
+    int rank;
+    MPI_Comm_rank(grid_comm, &rank);
 
+    int keep_row[2] = {0, 1};
     MPI_Comm row_comm;
-    MPI_Comm_split(MPI_COMM_WORLD, row, rank, &row_comm);
+    MPI_Cart_sub(grid_comm, keep_row, &row_comm);
 
+    int keep_col[2] = {1, 0};
     MPI_Comm col_comm;
-    MPI_Comm_split(MPI_COMM_WORLD, col, rank, &col_comm);
+    MPI_Cart_sub(grid_comm, keep_col, &col_comm);
 
     const int num_meas = 10;
-    double total_all_time = 0.0;
-    double total_row_time = 0.0;
-    double total_col_time = 0.0;
+    int result = 0;
 
-    for (int i = 0; i < num_meas; ++i) {
-        int global_sum = 0;
-        auto start_time = std::chrono::high_resolution_clock::now();
-        all_reduce(rank, global_sum);
-        auto end_time = std::chrono::high_resolution_clock::now();
-        total_all_time += std::chrono::duration<double>(end_time - start_time).count();
-
-        int row_sum = 0;
-        start_time = std::chrono::high_resolution_clock::now();
-        row_reduce(rank, row_comm, row_sum);
-        end_time = std::chrono::high_resolution_clock::now();
-        total_row_time += std::chrono::duration<double>(end_time - start_time).count();
-
-        int col_sum = 0;
-        start_time = std::chrono::high_resolution_clock::now();
-        col_reduce(rank, col_comm, col_sum);
-        end_time = std::chrono::high_resolution_clock::now();
-        total_col_time += std::chrono::duration<double>(end_time - start_time).count();
+    double avg_all_time = average_time([&] { all_reduce(rank, grid_comm, result); }, num_meas);
+    double avg_row_time = average_time([&] { row_reduce(rank, row_comm, result); }, num_meas);
+    double avg_col_time = average_time([&] { col_reduce(rank, col_comm, result); }, num_meas);
+
+    double avg_all_allreduce = average_time([&] { dim_allreduce(rank, grid_comm, result); }, num_meas);
+    double avg_row_allreduce = average_time([&] { dim_allreduce(rank, row_comm, result); }, num_meas);
+    double avg_col_allreduce = average_time([&] { dim_allreduce(rank, col_comm, result); }, num_meas);
+
+    double avg_all_bcast = average_time([&] { dim_bcast(rank, grid_comm, result); }, num_meas);
+    double avg_row_bcast = average_time([&] { dim_bcast(rank, row_comm, result); }, num_meas);
+    double avg_col_bcast = average_time([&] { dim_bcast(rank, col_comm, result); }, num_meas);
+
+    if (world_rank == 0) {
+        std::cout << "Grid Size,Avg All Time,Avg Row Time,Avg Col Time,"
+                  << "Avg All Allreduce,Avg Row Allreduce,Avg Col Allreduce,"
+                  << "Avg All Bcast,Avg Row Bcast,Avg Col Bcast" << std::endl;
+        std::cout << dims[0] << "x" << dims[1] << "," << avg_all_time << "," << avg_row_time << "," << avg_col_time << ","
+                  << avg_all_allreduce << "," << avg_row_allreduce << "," << avg_col_allreduce << ","
+                  << avg_all_bcast << "," << avg_row_bcast << "," << avg_col_bcast << std::endl;
+    }
+
+    // Fresh versus persistent collectives on the same buffers; enough calls
+    // that the per-call difference is above timer noise.
+    const int num_persistent_meas = 1000;
+    struct Target {
+        const char* name;
+        MPI_Comm comm;
+    };
+    Target targets[3] = {{"All", grid_comm}, {"Row", row_comm}, {"Col", col_comm}};
+    const char* kind_names[3] = {"Reduce", "Allreduce", "Bcast"};
+
+    if (world_rank == 0) {
+        std::cout << "Collective,Comm,Fresh Time,Persistent Time,Saved Per Call,Setup Time,Backend,Correct" << std::endl;
     }
+    for (int k = 0; k < 3; ++k) {
+        CollKind kind = static_cast<CollKind>(k);
+        for (const Target& t : targets) {
+            int comm_rank;
+            MPI_Comm_rank(t.comm, &comm_rank);
+            int value = rank, fresh = rank, persistent = rank;
+
+            double fresh_time = average_time([&] {
+                if (kind == COLL_REDUCE) {
+                    MPI_Reduce(&value, &fresh, 1, MPI_INT, MPI_SUM, 0, t.comm);
+                } else if (kind == COLL_ALLREDUCE) {
+                    MPI_Allreduce(&value, &fresh, 1, MPI_INT, MPI_SUM, t.comm);
+                } else {
+                    MPI_Bcast(&fresh, 1, MPI_INT, 0, t.comm);
+                }
+            }, num_persistent_meas);
+
+            MPI_Barrier(grid_comm);
+            auto setup_start = std::chrono::high_resolution_clock::now();
+            PersistentColl pc = persistent_init(kind, &value, &persistent, t.comm);
+            auto setup_end = std::chrono::high_resolution_clock::now();
+            double setup_time = std::chrono::duration<double>(setup_end - setup_start).count();
+
+            double persistent_time = average_time([&] { persistent_run(pc); }, num_persistent_meas);
+            persistent_free(pc);
 
-    double avg_all_time = total_all_time / num_meas;
-    double avg_row_time = total_row_time / num_meas;
-    double avg_col_time = total_col_time / num_meas;
+            int ok = (kind == COLL_REDUCE && comm_rank != 0) || fresh == persistent ? 1 : 0;
+            int all_ok = 0;
+            MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, grid_comm);
 
-    if (rank == 0) {
-        std::cout << "Grid Size,Avg All Time,Avg Row Time,Avg Col Time" << std::endl;
-        std::cout << grid_size << "x" << grid_size << "," << avg_all_time << "," << avg_row_time << "," << avg_col_time << std::endl;
+            if (world_rank == 0) {
+                std::cout << kind_names[k] << "," << t.name << "," << fresh_time << "," << persistent_time << ","
+                          << fresh_time - persistent_time << "," << setup_time << "," << persistent_backend() << ","
+                          << (all_ok ? "Yes" : "No") << std::endl;
+            }
+        }
     }
 
     MPI_Comm_free(&row_comm);
     MPI_Comm_free(&col_comm);
+    MPI_Comm_free(&grid_comm);
 
     MPI_Finalize();
     return 0;
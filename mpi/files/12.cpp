@@ -0,0 +1,271 @@
+#include <mpi.h>
+#include <omp.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+
+// SUMMA: C = A * B for N x N matrices block-distributed over a P x Q process
+// grid (the same Cartesian grid as 11.cpp). In each step the owners of a panel
+// of A's columns broadcast it along their grid row and the owners of the
+// matching panel of B's rows broadcast it along their grid column; every rank
+// then adds A_panel * B_panel to its block of C.
+
+const int panel_width = 128;
+const int tile = 64;
+
+int block_start(int index, int n, int parts) {
+    return static_cast<int>(static_cast<long long>(index) * n / parts);
+}
+
+int owner_of(int global, int n, int parts) {
+    int owner = static_cast<int>(static_cast<long long>(global) * parts / n);
+    while (block_start(owner + 1, n, parts) <= global) {
+        ++owner;
+    }
+    while (block_start(owner, n, parts) > global) {
+        --owner;
+    }
+    return owner;
+}
+
+double a_value(int i, int j) {
+    return ((i * 7 + j * 3) % 11 - 5) / 8.0;
+}
+
+double b_value(int i, int j) {
+    return ((i * 5 + j * 13) % 9 - 4) / 4.0;
+}
+
+// C (m x n) += A (m x w) * B (w x n), all row-major with leading dimensions
+// lda/ldb/ldc. Tiles of C rows are spread over OpenMP threads; inside a tile
+// the k loop is blocked so the B rows it touches stay in cache.
+// If pending is given, the master thread tests those requests after every
+// tile so nonblocking collectives progress during the multiply; that is the
+// only MPI call made inside the parallel region (MPI_THREAD_FUNNELED).
+void local_gemm(int m, int n, int w, const double* A, int lda, const double* B, int ldb, double* C, int ldc,
+                MPI_Request* pending = nullptr, int num_pending = 0) {
+    #pragma omp parallel for schedule(static)
+    for (int ii = 0; ii < m; ii += tile) {
+        int i_end = std::min(ii + tile, m);
+        for (int kk = 0; kk < w; kk += tile) {
+            if (pending != nullptr && omp_get_thread_num() == 0) {
+                int done;
+                MPI_Testall(num_pending, pending, &done, MPI_STATUSES_IGNORE);
+            }
+            int k_end = std::min(kk + tile, w);
+            for (int jj = 0; jj < n; jj += tile) {
+                int j_end = std::min(jj + tile, n);
+                for (int i = ii; i < i_end; ++i) {
+                    double* c_row = C + static_cast<size_t>(i) * ldc;
+                    for (int k = kk; k < k_end; ++k) {
+                        double a = A[static_cast<size_t>(i) * lda + k];
+                        const double* b_row = B + static_cast<size_t>(k) * ldb;
+                        for (int j = jj; j < j_end; ++j) {
+                            c_row[j] += a * b_row[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+struct Panel {
+    int k;
+    int width;
+};
+
+// Panels never cross a block boundary of A's columns (split over Q) or of
+// B's rows (split over P), so each has exactly one owner in each direction.
+std::vector<Panel> make_panels(int N, int P, int Q) {
+    std::vector<Panel> panels;
+    for (int k = 0; k < N;) {
+        int a_end = block_start(owner_of(k, N, Q) + 1, N, Q);
+        int b_end = block_start(owner_of(k, N, P) + 1, N, P);
+        int end = std::min(std::min(k + panel_width, N), std::min(a_end, b_end));
+        panels.push_back({k, end - k});
+        k = end;
+    }
+    return panels;
+}
+
+struct Grid {
+    int P, Q, row, col;
+    MPI_Comm comm, row_comm, col_comm;
+};
+
+// Broadcasts of panel s + 1 are in flight while panel s is multiplied; with
+// drive_progress local_gemm tests them between tiles, otherwise they only
+// advance inside MPI_Waitall.
+double summa(int N, const Grid& g, const std::vector<double>& A, const std::vector<double>& B, std::vector<double>& C,
+             bool drive_progress) {
+    int m = block_start(g.row + 1, N, g.P) - block_start(g.row, N, g.P);
+    int n = block_start(g.col + 1, N, g.Q) - block_start(g.col, N, g.Q);
+    int a_col0 = block_start(g.col, N, g.Q);
+    int b_row0 = block_start(g.row, N, g.P);
+    int a_cols = block_start(g.col + 1, N, g.Q) - a_col0;
+
+    std::vector<Panel> panels = make_panels(N, g.P, g.Q);
+    std::vector<double> a_buf[2], b_buf[2];
+    for (int b = 0; b < 2; ++b) {
+        a_buf[b].resize(static_cast<size_t>(m) * panel_width);
+        b_buf[b].resize(static_cast<size_t>(panel_width) * n);
+    }
+    MPI_Request reqs[2][2];
+    std::fill(C.begin(), C.end(), 0.0);
+
+    auto start_panel = [&](int s) {
+        const Panel& p = panels[s];
+        int buf = s % 2;
+        int a_root = owner_of(p.k, N, g.Q);
+        int b_root = owner_of(p.k, N, g.P);
+        if (g.col == a_root) {
+            for (int i = 0; i < m; ++i) {
+                std::copy(A.begin() + static_cast<size_t>(i) * a_cols + (p.k - a_col0),
+                          A.begin() + static_cast<size_t>(i) * a_cols + (p.k - a_col0) + p.width,
+                          a_buf[buf].begin() + static_cast<size_t>(i) * p.width);
+            }
+        }
+        if (g.row == b_root) {
+            std::copy(B.begin() + static_cast<size_t>(p.k - b_row0) * n,
+                      B.begin() + static_cast<size_t>(p.k - b_row0 + p.width) * n,
+                      b_buf[buf].begin());
+        }
+        MPI_Ibcast(a_buf[buf].data(), m * p.width, MPI_DOUBLE, a_root, g.row_comm, &reqs[buf][0]);
+        MPI_Ibcast(b_buf[buf].data(), p.width * n, MPI_DOUBLE, b_root, g.col_comm, &reqs[buf][1]);
+    };
+
+    MPI_Barrier(g.comm);
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    start_panel(0);
+    for (size_t s = 0; s < panels.size(); ++s) {
+        int buf = s % 2;
+        MPI_Waitall(2, reqs[buf], MPI_STATUSES_IGNORE);
+        MPI_Request* in_flight = nullptr;
+        if (s + 1 < panels.size()) {
+            start_panel(static_cast<int>(s + 1));
+            in_flight = drive_progress ? reqs[1 - buf] : nullptr;
+        }
+        local_gemm(m, n, panels[s].width, a_buf[buf].data(), panels[s].width, b_buf[buf].data(), n, C.data(), n,
+                   in_flight, 2);
+    }
+
+    MPI_Barrier(g.comm);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+// Largest |C - A*B| over this rank's block, using a plain triple loop.
+double max_error(int N, const Grid& g, const std::vector<double>& C) {
+    int row0 = block_start(g.row, N, g.P), row1 = block_start(g.row + 1, N, g.P);
+    int col0 = block_start(g.col, N, g.Q), col1 = block_start(g.col + 1, N, g.Q);
+    double err = 0.0;
+    for (int i = row0; i < row1; ++i) {
+        for (int j = col0; j < col1; ++j) {
+            double ref = 0.0;
+            for (int k = 0; k < N; ++k) {
+                ref += a_value(i, k) * b_value(k, j);
+            }
+            err = std::max(err, std::fabs(ref - C[static_cast<size_t>(i - row0) * (col1 - col0) + (j - col0)]));
+        }
+    }
+    return err;
+}
+
+int main(int argc, char** argv) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int size, world_rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    bool funneled = provided >= MPI_THREAD_FUNNELED;
+    if (!funneled && world_rank == 0) {
+        std::cerr << "MPI provides thread level " << provided << " < MPI_THREAD_FUNNELED; "
+                  << "broadcasts will not be progressed during the local multiply" << std::endl;
+    }
+
+    Grid g;
+    int dims[2] = {0, 0};
+    int periods[2] = {0, 0};
+    MPI_Dims_create(size, 2, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 1, &g.comm);
+    int rank, coords[2];
+    MPI_Comm_rank(g.comm, &rank);
+    MPI_Cart_coords(g.comm, rank, 2, coords);
+    g.P = dims[0];
+    g.Q = dims[1];
+    g.row = coords[0];
+    g.col = coords[1];
+
+    int keep_row[2] = {0, 1};
+    int keep_col[2] = {1, 0};
+    MPI_Cart_sub(g.comm, keep_row, &g.row_comm);
+    MPI_Cart_sub(g.comm, keep_col, &g.col_comm);
+
+    std::vector<int> sizes = {256, 512, 1024, 2048, 4096};
+    int max_n = argc > 1 ? std::atoi(argv[1]) : sizes.back();
+    const int check_limit = 1024;
+
+    if (rank == 0) {
+        std::cout << "N,grid,threads,time_sec,gflops,local_gflops,efficiency,max_error" << std::endl;
+    }
+
+    for (int N : sizes) {
+        if (N > max_n) {
+            break;
+        }
+        int row0 = block_start(g.row, N, g.P), m = block_start(g.row + 1, N, g.P) - row0;
+        int col0 = block_start(g.col, N, g.Q), n = block_start(g.col + 1, N, g.Q) - col0;
+        std::vector<double> A(static_cast<size_t>(m) * n), B(static_cast<size_t>(m) * n), C(static_cast<size_t>(m) * n);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                A[static_cast<size_t>(i) * n + j] = a_value(row0 + i, col0 + j);
+                B[static_cast<size_t>(i) * n + j] = b_value(row0 + i, col0 + j);
+            }
+        }
+
+        double time = summa(N, g, A, B, C, funneled);
+        double gflops = 2.0 * N * N * N / time / 1e9;
+
+        // Rate of the local kernel alone on this rank's block (best over ranks);
+        // efficiency is the achieved rate over size times that.
+        std::vector<double> local_c(static_cast<size_t>(m) * n, 0.0);
+        auto local_start = std::chrono::high_resolution_clock::now();
+        local_gemm(m, n, std::min(m, n), A.data(), n, B.data(), n, local_c.data(), n);
+        auto local_end = std::chrono::high_resolution_clock::now();
+        double local_time = std::chrono::duration<double>(local_end - local_start).count();
+        double local_gflops = 2.0 * m * n * std::min(m, n) / local_time / 1e9;
+        double best_local_gflops = 0.0;
+        MPI_Reduce(&local_gflops, &best_local_gflops, 1, MPI_DOUBLE, MPI_MAX, 0, g.comm);
+
+        double err = 0.0, global_err = 0.0;
+        if (N <= check_limit) {
+            err = max_error(N, g, C);
+        }
+        MPI_Reduce(&err, &global_err, 1, MPI_DOUBLE, MPI_MAX, 0, g.comm);
+
+        if (rank == 0) {
+            std::cout << N << "," << g.P << "x" << g.Q << "," << omp_get_max_threads() << ","
+                      << time << "," << gflops << "," << best_local_gflops << ","
+                      << gflops / (size * best_local_gflops) << ",";
+            if (N <= check_limit) {
+                std::cout << global_err;
+            } else {
+                std::cout << "n/a";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    MPI_Comm_free(&g.row_comm);
+    MPI_Comm_free(&g.col_comm);
+    MPI_Comm_free(&g.comm);
+
+    MPI_Finalize();
+    return 0;
+}
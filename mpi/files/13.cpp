@@ -0,0 +1,324 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+
+// 2D Jacobi iteration for the heat equation on an N x N grid, block-distributed
+// over a Cartesian process grid. Each rank stores its ny x nx block with a
+// one-cell halo, row-major, so halo rows are contiguous and halo columns are
+// described by an MPI_Type_vector. The top boundary is held at 1.0, the
+// others at 0.0. The halo exchange is either hand-written point-to-point or a
+// single neighborhood collective on the Cartesian communicator or on a
+// distributed graph that lists only the neighbours that exist.
+
+const int TAG_NORTH = 0;
+const int TAG_SOUTH = 1;
+const int TAG_WEST = 2;
+const int TAG_EAST = 3;
+
+int block_start(int index, int n, int parts) {
+    return static_cast<int>(static_cast<long long>(index) * n / parts);
+}
+
+struct Domain {
+    MPI_Comm comm;
+    MPI_Comm graph;
+    int dims[2];
+    int nx, ny;
+    int north, south, west, east;
+    MPI_Datatype column;
+    std::vector<double> u, unew;
+
+    int stride() const { return nx + 2; }
+    double* at(std::vector<double>& grid, int i, int j) const { return &grid[static_cast<size_t>(i) * stride() + j]; }
+};
+
+Domain make_domain(int N, int rows, int cols) {
+    Domain d;
+    d.dims[0] = rows;
+    d.dims[1] = cols;
+    int periods[2] = {0, 0};
+    MPI_Cart_create(MPI_COMM_WORLD, 2, d.dims, periods, 1, &d.comm);
+
+    int rank, coords[2];
+    MPI_Comm_rank(d.comm, &rank);
+    MPI_Cart_coords(d.comm, rank, 2, coords);
+    MPI_Cart_shift(d.comm, 0, 1, &d.north, &d.south);
+    MPI_Cart_shift(d.comm, 1, 1, &d.west, &d.east);
+
+    d.ny = block_start(coords[0] + 1, N, rows) - block_start(coords[0], N, rows);
+    d.nx = block_start(coords[1] + 1, N, cols) - block_start(coords[1], N, cols);
+
+    MPI_Type_vector(d.ny, 1, d.stride(), MPI_DOUBLE, &d.column);
+    MPI_Type_commit(&d.column);
+
+    d.u.assign(static_cast<size_t>(d.ny + 2) * d.stride(), 0.0);
+    if (d.north == MPI_PROC_NULL) {
+        std::fill(d.u.begin(), d.u.begin() + d.stride(), 1.0);
+    }
+    d.unew = d.u;
+
+    // Ranks on the edge of the grid have fewer than four neighbours; the graph
+    // keeps the Cartesian order (north, south, west, east) of those present.
+    std::vector<int> present;
+    for (int peer : {d.north, d.south, d.west, d.east}) {
+        if (peer != MPI_PROC_NULL) {
+            present.push_back(peer);
+        }
+    }
+    MPI_Dist_graph_create_adjacent(d.comm, static_cast<int>(present.size()), present.data(), MPI_UNWEIGHTED,
+                                   static_cast<int>(present.size()), present.data(), MPI_UNWEIGHTED,
+                                   MPI_INFO_NULL, 0, &d.graph);
+    return d;
+}
+
+void free_domain(Domain& d) {
+    MPI_Type_free(&d.column);
+    MPI_Comm_free(&d.graph);
+    MPI_Comm_free(&d.comm);
+}
+
+// Arguments of MPI_Neighbor_alltoallw for one halo exchange. Displacements are
+// byte offsets from the start of the grid, so one plan serves both buffers.
+struct NeighborPlan {
+    std::vector<int> send_counts, recv_counts;
+    std::vector<MPI_Aint> send_displs, recv_displs;
+    std::vector<MPI_Datatype> types;
+};
+
+NeighborPlan make_plan(const Domain& d, bool present_only) {
+    struct Face {
+        int peer;
+        int count;
+        MPI_Datatype type;
+        int send_i, send_j, recv_i, recv_j;
+    };
+    Face faces[4] = {
+        {d.north, d.nx, MPI_DOUBLE, 1, 1, 0, 1},
+        {d.south, d.nx, MPI_DOUBLE, d.ny, 1, d.ny + 1, 1},
+        {d.west, 1, d.column, 1, 1, 1, 0},
+        {d.east, 1, d.column, 1, d.nx, 1, d.nx + 1},
+    };
+    NeighborPlan plan;
+    for (const Face& f : faces) {
+        if (present_only && f.peer == MPI_PROC_NULL) {
+            continue;
+        }
+        plan.send_counts.push_back(f.count);
+        plan.recv_counts.push_back(f.count);
+        plan.send_displs.push_back(static_cast<MPI_Aint>((static_cast<size_t>(f.send_i) * d.stride() + f.send_j) * sizeof(double)));
+        plan.recv_displs.push_back(static_cast<MPI_Aint>((static_cast<size_t>(f.recv_i) * d.stride() + f.recv_j) * sizeof(double)));
+        plan.types.push_back(f.type);
+    }
+    return plan;
+}
+
+// The send and receive regions of a halo exchange are disjoint, so the same
+// grid is passed as both buffers.
+void neighbor_exchange(Domain& d, MPI_Comm comm, const NeighborPlan& plan, MPI_Request* req) {
+    const int* sc = plan.send_counts.data();
+    const int* rc = plan.recv_counts.data();
+    const MPI_Aint* sd = plan.send_displs.data();
+    const MPI_Aint* rd = plan.recv_displs.data();
+    const MPI_Datatype* t = plan.types.data();
+    if (req == nullptr) {
+        MPI_Neighbor_alltoallw(d.u.data(), sc, sd, t, d.u.data(), rc, rd, t, comm);
+    } else {
+        MPI_Ineighbor_alltoallw(d.u.data(), sc, sd, t, d.u.data(), rc, rd, t, comm, req);
+    }
+}
+
+void update_rect(Domain& d, int i0, int i1, int j0, int j1) {
+    int s = d.stride();
+    const double* u = d.u.data();
+    double* unew = d.unew.data();
+    for (int i = i0; i <= i1; ++i) {
+        for (int j = j0; j <= j1; ++j) {
+            size_t c = static_cast<size_t>(i) * s + j;
+            unew[c] = 0.25 * (u[c - s] + u[c + s] + u[c - 1] + u[c + 1]);
+        }
+    }
+}
+
+void update_interior(Domain& d) {
+    update_rect(d, 2, d.ny - 1, 2, d.nx - 1);
+}
+
+// The outer ring of owned cells, which reads the halo.
+void update_boundary(Domain& d) {
+    update_rect(d, 1, 1, 1, d.nx);
+    if (d.ny > 1) {
+        update_rect(d, d.ny, d.ny, 1, d.nx);
+    }
+    update_rect(d, 2, d.ny - 1, 1, 1);
+    if (d.nx > 1) {
+        update_rect(d, 2, d.ny - 1, d.nx, d.nx);
+    }
+}
+
+// Posts the four receives and four sends of one halo exchange on grid, either
+// as started requests or, for the persistent mode, as inactive ones.
+void post_halo(Domain& d, std::vector<double>& grid, MPI_Request* reqs, bool persistent) {
+    struct Transfer {
+        double* buf;
+        int count;
+        MPI_Datatype type;
+        int peer;
+        int tag;
+    };
+    Transfer recvs[4] = {
+        {d.at(grid, 0, 1), d.nx, MPI_DOUBLE, d.north, TAG_SOUTH},
+        {d.at(grid, d.ny + 1, 1), d.nx, MPI_DOUBLE, d.south, TAG_NORTH},
+        {d.at(grid, 1, 0), 1, d.column, d.west, TAG_EAST},
+        {d.at(grid, 1, d.nx + 1), 1, d.column, d.east, TAG_WEST},
+    };
+    Transfer sends[4] = {
+        {d.at(grid, 1, 1), d.nx, MPI_DOUBLE, d.north, TAG_NORTH},
+        {d.at(grid, d.ny, 1), d.nx, MPI_DOUBLE, d.south, TAG_SOUTH},
+        {d.at(grid, 1, 1), 1, d.column, d.west, TAG_WEST},
+        {d.at(grid, 1, d.nx), 1, d.column, d.east, TAG_EAST},
+    };
+    for (int k = 0; k < 4; ++k) {
+        if (persistent) {
+            MPI_Recv_init(recvs[k].buf, recvs[k].count, recvs[k].type, recvs[k].peer, recvs[k].tag, d.comm, &reqs[k]);
+            MPI_Send_init(sends[k].buf, sends[k].count, sends[k].type, sends[k].peer, sends[k].tag, d.comm, &reqs[4 + k]);
+        } else {
+            MPI_Irecv(recvs[k].buf, recvs[k].count, recvs[k].type, recvs[k].peer, recvs[k].tag, d.comm, &reqs[k]);
+            MPI_Isend(sends[k].buf, sends[k].count, sends[k].type, sends[k].peer, sends[k].tag, d.comm, &reqs[4 + k]);
+        }
+    }
+}
+
+void exchange_blocking(Domain& d) {
+    std::vector<double>& u = d.u;
+    MPI_Sendrecv(d.at(u, 1, 1), d.nx, MPI_DOUBLE, d.north, TAG_NORTH,
+                 d.at(u, d.ny + 1, 1), d.nx, MPI_DOUBLE, d.south, TAG_NORTH, d.comm, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(d.at(u, d.ny, 1), d.nx, MPI_DOUBLE, d.south, TAG_SOUTH,
+                 d.at(u, 0, 1), d.nx, MPI_DOUBLE, d.north, TAG_SOUTH, d.comm, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(d.at(u, 1, 1), 1, d.column, d.west, TAG_WEST,
+                 d.at(u, 1, d.nx + 1), 1, d.column, d.east, TAG_WEST, d.comm, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(d.at(u, 1, d.nx), 1, d.column, d.east, TAG_EAST,
+                 d.at(u, 1, 0), 1, d.column, d.west, TAG_EAST, d.comm, MPI_STATUS_IGNORE);
+}
+
+// Runs iters Jacobi steps in the given mode and returns the elapsed time.
+double run_jacobi(Domain& d, const std::string& mode, int iters) {
+    MPI_Request persistent[2][8];
+    if (mode == "persistent") {
+        post_halo(d, d.u, persistent[0], true);
+        post_halo(d, d.unew, persistent[1], true);
+    }
+    NeighborPlan cart_plan = make_plan(d, false);
+    NeighborPlan graph_plan = make_plan(d, true);
+
+    MPI_Barrier(d.comm);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int it = 0; it < iters; ++it) {
+        if (mode == "blocking" || mode == "neighbor") {
+            if (mode == "blocking") {
+                exchange_blocking(d);
+            } else {
+                neighbor_exchange(d, d.comm, cart_plan, nullptr);
+            }
+            update_interior(d);
+            update_boundary(d);
+        } else if (mode == "ineighbor" || mode == "graph") {
+            MPI_Request req;
+            if (mode == "ineighbor") {
+                neighbor_exchange(d, d.comm, cart_plan, &req);
+            } else {
+                neighbor_exchange(d, d.graph, graph_plan, &req);
+            }
+            update_interior(d);
+            MPI_Wait(&req, MPI_STATUS_IGNORE);
+            update_boundary(d);
+        } else {
+            MPI_Request fresh[8];
+            MPI_Request* reqs = fresh;
+            if (mode == "persistent") {
+                reqs = persistent[it % 2];
+                MPI_Startall(8, reqs);
+            } else {
+                post_halo(d, d.u, reqs, false);
+            }
+            update_interior(d);
+            MPI_Waitall(8, reqs, MPI_STATUSES_IGNORE);
+            update_boundary(d);
+        }
+        std::swap(d.u, d.unew);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    if (mode == "persistent") {
+        for (int b = 0; b < 2; ++b) {
+            for (int k = 0; k < 8; ++k) {
+                MPI_Request_free(&persistent[b][k]);
+            }
+        }
+    }
+    return std::chrono::duration<double>(end - start).count();
+}
+
+double checksum(Domain& d) {
+    double local = 0.0;
+    for (int i = 1; i <= d.ny; ++i) {
+        for (int j = 1; j <= d.nx; ++j) {
+            local += *d.at(d.u, i, j);
+        }
+    }
+    double total = 0.0;
+    MPI_Allreduce(&local, &total, 1, MPI_DOUBLE, MPI_SUM, d.comm);
+    return total;
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int N = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    int square[2] = {0, 0};
+    MPI_Dims_create(size, 2, square);
+    std::vector<std::pair<int, int>> shapes = {{square[0], square[1]}};
+    for (auto strip : {std::make_pair(size, 1), std::make_pair(1, size)}) {
+        if (std::find(shapes.begin(), shapes.end(), strip) == shapes.end()) {
+            shapes.push_back(strip);
+        }
+    }
+    std::vector<std::string> modes = {"blocking", "overlap", "persistent", "neighbor", "ineighbor", "graph"};
+
+    if (rank == 0) {
+        std::cout << "N,grid,mode,iterations,time_per_iter_sec,cells_per_sec,checksum,matches_blocking" << std::endl;
+    }
+
+    for (const auto& shape : shapes) {
+        double reference = 0.0;
+        for (const auto& mode : modes) {
+            Domain d = make_domain(N, shape.first, shape.second);
+            double time = run_jacobi(d, mode, iters);
+            double sum = checksum(d);
+            if (mode == "blocking") {
+                reference = sum;
+            }
+
+            if (rank == 0) {
+                std::cout << N << "," << shape.first << "x" << shape.second << "," << mode << "," << iters << ","
+                          << time / iters << "," << static_cast<double>(N) * N * iters / time << ","
+                          << sum << "," << (sum == reference ? "Yes" : "No") << std::endl;
+            }
+            free_domain(d);
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <chrono>
+
+// One-sided (RMA) versions of the ping-pong from 3.cpp/8.cpp, the gather from
+// 9.cpp and the min reduction from 1.cpp, each printed next to its two-sided
+// counterpart. Every RMA variant is run under the three synchronization
+// models: active target with MPI_Win_fence, active target with
+// post/start/complete/wait (PSCW), and passive target with lock_all/flush.
+
+enum Sync { SYNC_FENCE, SYNC_PSCW, SYNC_LOCK_ALL };
+
+const int num_meas = 100;
+
+// Opens an epoch on win. access is the group this rank will issue RMA calls
+// to and expose the group allowed to target this rank (PSCW only);
+// MPI_GROUP_NULL means none.
+void epoch_begin(Sync sync, MPI_Win win, MPI_Group access, MPI_Group expose) {
+    if (sync == SYNC_FENCE) {
+        MPI_Win_fence(0, win);
+    } else if (sync == SYNC_PSCW) {
+        if (expose != MPI_GROUP_NULL) {
+            MPI_Win_post(expose, 0, win);
+        }
+        if (access != MPI_GROUP_NULL) {
+            MPI_Win_start(access, 0, win);
+        }
+    } else {
+        MPI_Win_lock_all(0, win);
+    }
+}
+
+// Closes the epoch; afterwards every target can read what was written to it.
+// Passive target has no notification of its own, so it ends in a barrier.
+void epoch_end(Sync sync, MPI_Win win, MPI_Group access, MPI_Group expose, MPI_Comm comm) {
+    if (sync == SYNC_FENCE) {
+        MPI_Win_fence(0, win);
+    } else if (sync == SYNC_PSCW) {
+        if (access != MPI_GROUP_NULL) {
+            MPI_Win_complete(win);
+        }
+        if (expose != MPI_GROUP_NULL) {
+            MPI_Win_wait(win);
+        }
+    } else {
+        MPI_Win_unlock_all(win);
+        MPI_Barrier(comm);
+    }
+}
+
+MPI_Group single_group(MPI_Comm comm, int rank) {
+    MPI_Group all, one;
+    MPI_Comm_group(comm, &all);
+    MPI_Group_incl(all, 1, &rank, &one);
+    MPI_Group_free(&all);
+    return one;
+}
+
+void free_group(MPI_Group& group) {
+    if (group != MPI_GROUP_NULL) {
+        MPI_Group_free(&group);
+    }
+}
+
+template <typename Op>
+double average_time(MPI_Comm comm, Op op, int runs) {
+    MPI_Barrier(comm);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < runs; ++i) {
+        op();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count() / runs;
+}
+
+// ---------------------------------------------------------------- ping-pong
+
+void pingpong_send_recv(char* snd_buf, char* rcv_buf, int msg_size, int rank, MPI_Comm comm) {
+    if (rank == 0) {
+        MPI_Send(snd_buf, msg_size, MPI_CHAR, 1, 0, comm);
+        MPI_Recv(rcv_buf, msg_size, MPI_CHAR, 1, 0, comm, MPI_STATUS_IGNORE);
+    } else {
+        MPI_Recv(rcv_buf, msg_size, MPI_CHAR, 0, 0, comm, MPI_STATUS_IGNORE);
+        MPI_Send(snd_buf, msg_size, MPI_CHAR, 0, 0, comm);
+    }
+}
+
+void pingpong_sendrecv(char* snd_buf, char* rcv_buf, int msg_size, int rank, MPI_Comm comm) {
+    MPI_Sendrecv(snd_buf, msg_size, MPI_CHAR, 1 - rank, 0, rcv_buf, msg_size, MPI_CHAR, 1 - rank, 0,
+                 comm, MPI_STATUS_IGNORE);
+}
+
+// One round trip as two active-target epochs: 0 puts into 1, then 1 into 0.
+void pingpong_active(Sync sync, const char* snd_buf, int msg_size, int rank, MPI_Win win,
+                     MPI_Group peer, MPI_Comm comm) {
+    for (int from = 0; from < 2; ++from) {
+        MPI_Group access = rank == from ? peer : MPI_GROUP_NULL;
+        MPI_Group expose = rank == from ? MPI_GROUP_NULL : peer;
+        epoch_begin(sync, win, access, expose);
+        if (rank == from) {
+            MPI_Put(snd_buf, msg_size, MPI_CHAR, 1 - rank, 0, msg_size, MPI_CHAR, win);
+        }
+        epoch_end(sync, win, access, expose, comm);
+    }
+}
+
+// Passive target: the payload is put and flushed, then a sequence number is
+// written behind it; the receiver polls its own flag with an atomic read.
+// Called inside a lock_all epoch.
+void pingpong_passive(const char* snd_buf, int msg_size, int rank, MPI_Win win, MPI_Aint flag_disp, int& seq) {
+    int peer = 1 - rank;
+    for (int from = 0; from < 2; ++from) {
+        ++seq;
+        if (rank == from) {
+            MPI_Put(snd_buf, msg_size, MPI_CHAR, peer, 0, msg_size, MPI_CHAR, win);
+            MPI_Win_flush(peer, win);
+            MPI_Accumulate(&seq, 1, MPI_INT, peer, flag_disp, 1, MPI_INT, MPI_REPLACE, win);
+            MPI_Win_flush(peer, win);
+        } else {
+            int flag = 0;
+            while (flag != seq) {
+                MPI_Fetch_and_op(nullptr, &flag, MPI_INT, rank, flag_disp, MPI_NO_OP, win);
+                MPI_Win_flush(rank, win);
+            }
+        }
+    }
+}
+
+void run_pingpong(int world_rank) {
+    // Only ranks 0 and 1 take part, so fences do not involve the others.
+    MPI_Comm pair;
+    MPI_Comm_split(MPI_COMM_WORLD, world_rank < 2 ? 0 : MPI_UNDEFINED, world_rank, &pair);
+    if (world_rank == 0) {
+        std::cout << "msg_size,send_recv_time,sendrecv_time,fence_time,pscw_time,lock_all_time" << std::endl;
+    }
+    if (pair == MPI_COMM_NULL) {
+        return;
+    }
+
+    int rank;
+    MPI_Comm_rank(pair, &rank);
+    MPI_Group peer = single_group(pair, 1 - rank);
+
+    std::vector<int> msg_sizes = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    for (int msg_size : msg_sizes) {
+        std::vector<char> snd_buf(msg_size, static_cast<char>(rank + 1));
+        std::vector<char> rcv_buf(msg_size, 0);
+
+        // The flag lives behind the payload, aligned for an int.
+        MPI_Aint flag_disp = (msg_size + alignof(int) - 1) / alignof(int) * alignof(int);
+        char* base;
+        MPI_Win win;
+        MPI_Win_allocate(flag_disp + sizeof(int), 1, MPI_INFO_NULL, pair, &base, &win);
+        std::memset(base, 0, flag_disp + sizeof(int));
+        MPI_Barrier(pair);
+
+        double t_send_recv = average_time(pair, [&] { pingpong_send_recv(snd_buf.data(), rcv_buf.data(), msg_size, rank, pair); }, num_meas);
+        double t_sendrecv = average_time(pair, [&] { pingpong_sendrecv(snd_buf.data(), rcv_buf.data(), msg_size, rank, pair); }, num_meas);
+        double t_fence = average_time(pair, [&] { pingpong_active(SYNC_FENCE, snd_buf.data(), msg_size, rank, win, peer, pair); }, num_meas);
+        double t_pscw = average_time(pair, [&] { pingpong_active(SYNC_PSCW, snd_buf.data(), msg_size, rank, win, peer, pair); }, num_meas);
+
+        int seq = 0;
+        MPI_Win_lock_all(0, win);
+        double t_lock_all = average_time(pair, [&] { pingpong_passive(snd_buf.data(), msg_size, rank, win, flag_disp, seq); }, num_meas);
+        MPI_Win_unlock_all(win);
+
+        MPI_Win_free(&win);
+
+        if (rank == 0) {
+            std::cout << msg_size << "," << t_send_recv << "," << t_sendrecv << ","
+                      << t_fence << "," << t_pscw << "," << t_lock_all << std::endl;
+        }
+    }
+
+    free_group(peer);
+    MPI_Comm_free(&pair);
+}
+
+// ------------------------------------------------------------------- gather
+
+// Every rank puts its block at offset rank * count of the root's window.
+void gather_rma(Sync sync, const int* local, int count, int rank, MPI_Win win,
+                MPI_Group root_group, MPI_Group all_group) {
+    MPI_Group expose = rank == 0 ? all_group : MPI_GROUP_NULL;
+    epoch_begin(sync, win, root_group, expose);
+    MPI_Put(local, count, MPI_INT, 0, static_cast<MPI_Aint>(rank) * count, count, MPI_INT, win);
+    epoch_end(sync, win, root_group, expose, MPI_COMM_WORLD);
+}
+
+bool gather_correct(const int* gathered, int count, int n_procs) {
+    for (int r = 0; r < n_procs; ++r) {
+        for (int i = 0; i < count; ++i) {
+            if (gathered[static_cast<size_t>(r) * count + i] != r * 7 + i % 13) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void run_gather(int rank, int n_procs) {
+    if (rank == 0) {
+        std::cout << "count_per_rank,proc_count,mpi_gather_time,fence_time,pscw_time,lock_all_time,correct" << std::endl;
+    }
+
+    MPI_Group root_group = single_group(MPI_COMM_WORLD, 0);
+    MPI_Group all_group;
+    MPI_Comm_group(MPI_COMM_WORLD, &all_group);
+
+    std::vector<int> counts = {1, 100, 10000, 1000000};
+    for (int count : counts) {
+        std::vector<int> local(count);
+        for (int i = 0; i < count; ++i) {
+            local[i] = rank * 7 + i % 13;
+        }
+        size_t total = static_cast<size_t>(count) * n_procs;
+        std::vector<int> gathered(rank == 0 ? total : 0);
+
+        int* base;
+        MPI_Win win;
+        MPI_Win_allocate(rank == 0 ? total * sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &base, &win);
+
+        int runs = count >= 1000000 ? 10 : num_meas;
+        bool ok = true;
+
+        double t_mpi = average_time(MPI_COMM_WORLD, [&] {
+            MPI_Gather(local.data(), count, MPI_INT, gathered.data(), count, MPI_INT, 0, MPI_COMM_WORLD);
+        }, runs);
+        if (rank == 0) {
+            ok = ok && gather_correct(gathered.data(), count, n_procs);
+        }
+
+        double t_sync[3];
+        Sync syncs[3] = {SYNC_FENCE, SYNC_PSCW, SYNC_LOCK_ALL};
+        for (int s = 0; s < 3; ++s) {
+            if (rank == 0) {
+                std::fill(base, base + total, -1);
+            }
+            t_sync[s] = average_time(MPI_COMM_WORLD, [&] { gather_rma(syncs[s], local.data(), count, rank, win, root_group, all_group); }, runs);
+            if (rank == 0) {
+                ok = ok && gather_correct(base, count, n_procs);
+            }
+        }
+
+        MPI_Win_free(&win);
+
+        if (rank == 0) {
+            std::cout << count << "," << n_procs << "," << t_mpi << "," << t_sync[0] << ","
+                      << t_sync[1] << "," << t_sync[2] << "," << (ok ? "Yes" : "No") << std::endl;
+        }
+    }
+
+    MPI_Group_free(&root_group);
+    MPI_Group_free(&all_group);
+}
+
+// ------------------------------------------------------------ min reduction
+
+int par_min_two_sided(const std::vector<int>& data, int local_size, int rank) {
+    std::vector<int> local_data(local_size);
+    MPI_Scatter(data.data(), local_size, MPI_INT, local_data.data(), local_size, MPI_INT, 0, MPI_COMM_WORLD);
+    int local_min = *std::min_element(local_data.begin(), local_data.end());
+    int global_min = INT_MAX;
+    MPI_Reduce(&local_min, &global_min, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+    return rank == 0 ? global_min : 0;
+}
+
+// Each rank gets its slice straight out of the root's data window, then folds
+// its minimum into the root's result word with MPI_MIN, either with
+// MPI_Accumulate or with MPI_Get_accumulate (which also returns the minimum
+// seen so far). Returns the result on the root.
+int par_min_rma(Sync sync, bool fetch, int local_size, int rank, MPI_Win data_win, MPI_Win result_win,
+                int* result, MPI_Group root_group, MPI_Group all_group) {
+    MPI_Group expose = rank == 0 ? all_group : MPI_GROUP_NULL;
+
+    std::vector<int> local_data(local_size);
+    epoch_begin(sync, data_win, root_group, expose);
+    MPI_Get(local_data.data(), local_size, MPI_INT, 0, static_cast<MPI_Aint>(rank) * local_size, local_size, MPI_INT, data_win);
+    epoch_end(sync, data_win, root_group, expose, MPI_COMM_WORLD);
+
+    int local_min = *std::min_element(local_data.begin(), local_data.end());
+    int previous = 0;
+    epoch_begin(sync, result_win, root_group, expose);
+    if (fetch) {
+        MPI_Get_accumulate(&local_min, 1, MPI_INT, &previous, 1, MPI_INT, 0, 0, 1, MPI_INT, MPI_MIN, result_win);
+    } else {
+        MPI_Accumulate(&local_min, 1, MPI_INT, 0, 0, 1, MPI_INT, MPI_MIN, result_win);
+    }
+    epoch_end(sync, result_win, root_group, expose, MPI_COMM_WORLD);
+
+    return rank == 0 ? *result : 0;
+}
+
+void run_reduce(int rank, int n_procs) {
+    if (rank == 0) {
+        std::cout << "vec_size,proc_count,scatter_reduce_time,fence_acc_time,pscw_acc_time,lock_all_acc_time,"
+                  << "lock_all_get_acc_time,min,correct" << std::endl;
+    }
+
+    MPI_Group root_group = single_group(MPI_COMM_WORLD, 0);
+    MPI_Group all_group;
+    MPI_Comm_group(MPI_COMM_WORLD, &all_group);
+
+    std::vector<int> vec_sizes = {1000, 10000, 100000, 1000000, 10000000};
+    for (int N : vec_sizes) {
+        int local_size = N / n_procs;
+        std::vector<int> data;
+        if (rank == 0) {
+            data.resize(N);
+            std::srand(12345);
+            for (int i = 0; i < N; ++i) {
+                data[i] = std::rand() % 1000;
+            }
+        }
+
+        // The root's vector is copied into window memory from MPI_Win_allocate
+        // rather than exposed with MPI_Win_create, which Open MPI only supports
+        // with more than one process.
+        MPI_Win data_win, result_win;
+        int* window_data;
+        MPI_Win_allocate(rank == 0 ? static_cast<MPI_Aint>(N) * sizeof(int) : 0, sizeof(int),
+                         MPI_INFO_NULL, MPI_COMM_WORLD, &window_data, &data_win);
+        std::copy(data.begin(), data.end(), window_data);
+        MPI_Barrier(MPI_COMM_WORLD);
+        int* result;
+        MPI_Win_allocate(rank == 0 ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &result, &result_win);
+
+        int runs = N >= 1000000 ? 10 : num_meas;
+        int expected = 0;
+        double t_two_sided = average_time(MPI_COMM_WORLD, [&] { expected = par_min_two_sided(data, local_size, rank); }, runs);
+
+        struct Variant {
+            Sync sync;
+            bool fetch;
+        };
+        Variant variants[4] = {{SYNC_FENCE, false}, {SYNC_PSCW, false}, {SYNC_LOCK_ALL, false}, {SYNC_LOCK_ALL, true}};
+        double t_rma[4];
+        bool ok = true;
+        for (int v = 0; v < 4; ++v) {
+            // MPI_MIN is idempotent, so like the gather windows the result is
+            // reset once per variant and the timed runs carry no extra sync.
+            if (rank == 0) {
+                MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, result_win);
+                *result = INT_MAX;
+                MPI_Win_unlock(0, result_win);
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+            int got = 0;
+            t_rma[v] = average_time(MPI_COMM_WORLD, [&] {
+                got = par_min_rma(variants[v].sync, variants[v].fetch, local_size, rank, data_win, result_win,
+                                  result, root_group, all_group);
+            }, runs);
+            ok = ok && got == expected;
+        }
+
+        MPI_Win_free(&result_win);
+        MPI_Win_free(&data_win);
+
+        if (rank == 0) {
+            std::cout << N << "," << n_procs << "," << t_two_sided << "," << t_rma[0] << "," << t_rma[1] << ","
+                      << t_rma[2] << "," << t_rma[3] << "," << expected << "," << (ok ? "Yes" : "No") << std::endl;
+        }
+    }
+
+    MPI_Group_free(&root_group);
+    MPI_Group_free(&all_group);
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::string suite = argc > 1 ? argv[1] : "all";
+
+    if (suite == "all" || suite == "pingpong") {
+        if (size < 2) {
+            if (rank == 0) {
+                std::cerr << "pingpong needs at least 2 processes" << std::endl;
+            }
+        } else {
+            run_pingpong(rank);
+        }
+    }
+    if (suite == "all" || suite == "gather") {
+        run_gather(rank, size);
+    }
+    if (suite == "all" || suite == "reduce") {
+        run_reduce(rank, size);
+    }
+
+    MPI_Finalize();
+    return 0;
+}
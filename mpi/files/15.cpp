@@ -0,0 +1,173 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+
+// Two-level reduce, allreduce and bcast. Ranks are grouped by node with
+// MPI_Comm_split_type(MPI_COMM_TYPE_SHARED); data is combined inside each node
+// first, only one leader per node (node rank 0) talks over the network, and
+// the result is fanned out inside the node again. Everything is rooted at
+// world rank 0, which is always the leader of its node. The reduction op must
+// be commutative, since ranks are combined in node order. With a single node
+// the leader stage is skipped and the collective runs on the node alone.
+
+struct Hierarchy {
+    MPI_Comm node;
+    MPI_Comm leaders;
+    int node_rank;
+    int nodes;
+};
+
+// ranks_per_node > 0 groups consecutive ranks instead of asking MPI which
+// share memory, to try the hierarchy on a single machine.
+Hierarchy make_hierarchy(int rank, int ranks_per_node) {
+    Hierarchy h;
+    if (ranks_per_node > 0) {
+        MPI_Comm_split(MPI_COMM_WORLD, rank / ranks_per_node, rank, &h.node);
+    } else {
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &h.node);
+    }
+    MPI_Comm_rank(h.node, &h.node_rank);
+    MPI_Comm_split(MPI_COMM_WORLD, h.node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &h.leaders);
+
+    h.nodes = 0;
+    if (h.leaders != MPI_COMM_NULL) {
+        MPI_Comm_size(h.leaders, &h.nodes);
+    }
+    MPI_Bcast(&h.nodes, 1, MPI_INT, 0, h.node);
+    return h;
+}
+
+void free_hierarchy(Hierarchy& h) {
+    if (h.leaders != MPI_COMM_NULL) {
+        MPI_Comm_free(&h.leaders);
+    }
+    MPI_Comm_free(&h.node);
+}
+
+void hier_reduce(const void* data, void* result, int count, MPI_Datatype type, MPI_Op op,
+                 const Hierarchy& h, std::vector<char>& scratch) {
+    if (h.nodes == 1) {
+        MPI_Reduce(data, result, count, type, op, 0, h.node);
+        return;
+    }
+    int type_size;
+    MPI_Type_size(type, &type_size);
+    scratch.resize(static_cast<size_t>(count) * type_size);
+
+    MPI_Reduce(data, scratch.data(), count, type, op, 0, h.node);
+    if (h.leaders != MPI_COMM_NULL) {
+        MPI_Reduce(scratch.data(), result, count, type, op, 0, h.leaders);
+    }
+}
+
+void hier_allreduce(const void* data, void* result, int count, MPI_Datatype type, MPI_Op op,
+                    const Hierarchy& h, std::vector<char>& scratch) {
+    if (h.nodes == 1) {
+        MPI_Allreduce(data, result, count, type, op, h.node);
+        return;
+    }
+    int type_size;
+    MPI_Type_size(type, &type_size);
+    scratch.resize(static_cast<size_t>(count) * type_size);
+
+    MPI_Reduce(data, scratch.data(), count, type, op, 0, h.node);
+    if (h.leaders != MPI_COMM_NULL) {
+        MPI_Allreduce(scratch.data(), result, count, type, op, h.leaders);
+    }
+    MPI_Bcast(result, count, type, 0, h.node);
+}
+
+void hier_bcast(void* data, int count, MPI_Datatype type, const Hierarchy& h) {
+    if (h.leaders != MPI_COMM_NULL && h.nodes > 1) {
+        MPI_Bcast(data, count, type, 0, h.leaders);
+    }
+    MPI_Bcast(data, count, type, 0, h.node);
+}
+
+template <typename Op>
+double average_time(Op op, int runs) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < runs; ++i) {
+        op();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double local = std::chrono::duration<double>(end - start).count() / runs;
+    double slowest = 0.0;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return slowest;
+}
+
+int runs_for_bytes(long long bytes) {
+    return bytes <= 64 * 1024 ? 200 : (bytes <= 1024 * 1024 ? 50 : 10);
+}
+
+bool all_ranks_agree(bool local_ok) {
+    int ok = local_ok ? 1 : 0, all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return all_ok != 0;
+}
+
+void report(int rank, const std::string& collective, int count, int size, const Hierarchy& h,
+            double flat, double hier, bool correct) {
+    if (rank == 0) {
+        std::cout << collective << "," << count << "," << static_cast<long long>(count) * sizeof(double) << ","
+                  << size << "," << h.nodes << "," << flat << "," << hier << "," << flat / hier << ","
+                  << (correct ? "Yes" : "No") << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int ranks_per_node = argc > 1 ? std::atoi(argv[1]) : 0;
+    Hierarchy h = make_hierarchy(rank, ranks_per_node);
+
+    if (rank == 0) {
+        std::cout << "collective,count,bytes,proc_count,nodes,flat_time,hier_time,speedup,correct" << std::endl;
+    }
+
+    std::vector<int> counts = {1, 1024, 65536, 1048576};
+    std::vector<char> scratch;
+
+    for (int count : counts) {
+        // Small integers keep every sum exact, so flat and hierarchical
+        // results must match bit for bit.
+        std::vector<double> data(count), flat_result(count), hier_result(count);
+        for (int i = 0; i < count; ++i) {
+            data[i] = rank + i % 7;
+        }
+        int runs = runs_for_bytes(static_cast<long long>(count) * sizeof(double));
+
+        double flat = average_time([&] { MPI_Reduce(data.data(), flat_result.data(), count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD); }, runs);
+        double hier = average_time([&] { hier_reduce(data.data(), hier_result.data(), count, MPI_DOUBLE, MPI_SUM, h, scratch); }, runs);
+        report(rank, "reduce", count, size, h, flat, hier, all_ranks_agree(rank != 0 || flat_result == hier_result));
+
+        std::fill(hier_result.begin(), hier_result.end(), 0.0);
+        flat = average_time([&] { MPI_Allreduce(data.data(), flat_result.data(), count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD); }, runs);
+        hier = average_time([&] { hier_allreduce(data.data(), hier_result.data(), count, MPI_DOUBLE, MPI_SUM, h, scratch); }, runs);
+        report(rank, "allreduce", count, size, h, flat, hier, all_ranks_agree(flat_result == hier_result));
+
+        std::vector<double> flat_buf(count, 0.0), hier_buf(count, 0.0);
+        if (rank == 0) {
+            flat_buf = data;
+            hier_buf = data;
+        }
+        flat = average_time([&] { MPI_Bcast(flat_buf.data(), count, MPI_DOUBLE, 0, MPI_COMM_WORLD); }, runs);
+        hier = average_time([&] { hier_bcast(hier_buf.data(), count, MPI_DOUBLE, h); }, runs);
+        report(rank, "bcast", count, size, h, flat, hier, all_ranks_agree(flat_buf == hier_buf && hier_buf[count - 1] == (count - 1) % 7));
+    }
+
+    free_hierarchy(h);
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+// Conjugate gradients for the 5-point Poisson matrix on an n x n grid
+// (n^2 unknowns, SPD). Grid rows are block-distributed; each rank stores its
+// rows of the matrix in CSR with column indices into an extended vector that
+// has one halo grid row above and below the owned ones:
+//   [halo row from up][owned rows ...][halo row from down]
+// The right-hand side is A * 1, so the exact solution is all ones.
+//
+// The classic variant does two blocking MPI_Allreduce per iteration. The
+// pipelined variant (Ghysels & Vanroose) fuses them into one MPI_Iallreduce
+// that is in flight while the next SpMV runs.
+
+const double tolerance = 1e-8;
+
+int block_start(int index, int n, int parts) {
+    return static_cast<int>(static_cast<long long>(index) * n / parts);
+}
+
+struct Poisson {
+    int n;
+    int row0, rows;
+    int up, down;
+    std::vector<int> row_ptr;
+    std::vector<int> cols;
+    std::vector<double> vals;
+
+    int owned() const { return rows * n; }
+    size_t extended() const { return static_cast<size_t>(rows + 2) * n; }
+};
+
+Poisson make_poisson(int n, int rank, int size) {
+    Poisson A;
+    A.n = n;
+    A.row0 = block_start(rank, n, size);
+    A.rows = block_start(rank + 1, n, size) - A.row0;
+    A.up = rank > 0 ? rank - 1 : MPI_PROC_NULL;
+    A.down = rank < size - 1 ? rank + 1 : MPI_PROC_NULL;
+
+    A.row_ptr.push_back(0);
+    for (int li = 0; li < A.rows; ++li) {
+        int gi = A.row0 + li;
+        for (int j = 0; j < n; ++j) {
+            int self = (li + 1) * n + j;
+            if (gi > 0) {
+                A.cols.push_back(self - n);
+                A.vals.push_back(-1.0);
+            }
+            if (j > 0) {
+                A.cols.push_back(self - 1);
+                A.vals.push_back(-1.0);
+            }
+            A.cols.push_back(self);
+            A.vals.push_back(4.0);
+            if (j < n - 1) {
+                A.cols.push_back(self + 1);
+                A.vals.push_back(-1.0);
+            }
+            if (gi < n - 1) {
+                A.cols.push_back(self + n);
+                A.vals.push_back(-1.0);
+            }
+            A.row_ptr.push_back(static_cast<int>(A.cols.size()));
+        }
+    }
+    return A;
+}
+
+void halo_exchange(const Poisson& A, std::vector<double>& x) {
+    int n = A.n;
+    MPI_Request reqs[4];
+    MPI_Irecv(&x[0], n, MPI_DOUBLE, A.up, 0, MPI_COMM_WORLD, &reqs[0]);
+    MPI_Irecv(&x[static_cast<size_t>(A.rows + 1) * n], n, MPI_DOUBLE, A.down, 1, MPI_COMM_WORLD, &reqs[1]);
+    MPI_Isend(&x[n], n, MPI_DOUBLE, A.up, 1, MPI_COMM_WORLD, &reqs[2]);
+    MPI_Isend(&x[static_cast<size_t>(A.rows) * n], n, MPI_DOUBLE, A.down, 0, MPI_COMM_WORLD, &reqs[3]);
+    MPI_Waitall(4, reqs, MPI_STATUSES_IGNORE);
+}
+
+// y = A x on the owned rows; both vectors use the extended layout.
+void spmv(const Poisson& A, std::vector<double>& x, std::vector<double>& y) {
+    halo_exchange(A, x);
+    double* out = y.data() + A.n;
+    for (int r = 0; r < A.owned(); ++r) {
+        double sum = 0.0;
+        for (int k = A.row_ptr[r]; k < A.row_ptr[r + 1]; ++k) {
+            sum += A.vals[k] * x[A.cols[k]];
+        }
+        out[r] = sum;
+    }
+}
+
+double local_dot(const Poisson& A, const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0.0;
+    for (size_t i = A.n; i < A.n + static_cast<size_t>(A.owned()); ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+double global_dot(const Poisson& A, const std::vector<double>& a, const std::vector<double>& b) {
+    double local = local_dot(A, a, b), global = 0.0;
+    MPI_Allreduce(&local, &global, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return global;
+}
+
+struct CgResult {
+    int iterations;
+    double time;
+    double residual;  // ||r|| / ||b|| as tracked by the recurrence
+};
+
+CgResult cg_classic(const Poisson& A, const std::vector<double>& b, std::vector<double>& x, int max_iters) {
+    size_t len = A.extended();
+    std::vector<double> r(len, 0.0), p(len, 0.0), Ap(len, 0.0);
+    int lo = A.n, hi = A.n + A.owned();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    spmv(A, x, Ap);
+    for (int i = lo; i < hi; ++i) {
+        r[i] = b[i] - Ap[i];
+        p[i] = r[i];
+    }
+    double bb = global_dot(A, b, b);
+    double rr = global_dot(A, r, r);
+
+    int it = 0;
+    while (it < max_iters && std::sqrt(rr / bb) > tolerance) {
+        spmv(A, p, Ap);
+        double alpha = rr / global_dot(A, p, Ap);
+        for (int i = lo; i < hi; ++i) {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+        }
+        double rr_new = global_dot(A, r, r);
+        double beta = rr_new / rr;
+        rr = rr_new;
+        for (int i = lo; i < hi; ++i) {
+            p[i] = r[i] + beta * p[i];
+        }
+        ++it;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return {it, std::chrono::duration<double>(end - start).count(), std::sqrt(rr / bb)};
+}
+
+// Each iteration starts one MPI_Iallreduce of (r.r, w.r) and computes
+// q = A w while it is in flight; the scalars it returns drive every update
+// that follows.
+CgResult cg_pipelined(const Poisson& A, const std::vector<double>& b, std::vector<double>& x, int max_iters) {
+    size_t len = A.extended();
+    std::vector<double> r(len, 0.0), w(len, 0.0), q(len, 0.0);
+    std::vector<double> z(len, 0.0), s(len, 0.0), p(len, 0.0);
+    int lo = A.n, hi = A.n + A.owned();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    spmv(A, x, q);
+    for (int i = lo; i < hi; ++i) {
+        r[i] = b[i] - q[i];
+    }
+    spmv(A, r, w);
+    double bb = global_dot(A, b, b);
+
+    double gamma_old = 0.0, alpha_old = 0.0, rr = 0.0;
+    int it = 0;
+    while (true) {
+        double local[2] = {local_dot(A, r, r), local_dot(A, w, r)};
+        double global[2];
+        MPI_Request req;
+        MPI_Iallreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+        spmv(A, w, q);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+
+        double gamma = global[0], delta = global[1];
+        rr = gamma;
+        if (it >= max_iters || std::sqrt(rr / bb) <= tolerance) {
+            break;
+        }
+        double beta = 0.0, alpha = gamma / delta;
+        if (it > 0) {
+            beta = gamma / gamma_old;
+            alpha = gamma / (delta - beta * gamma / alpha_old);
+        }
+        for (int i = lo; i < hi; ++i) {
+            z[i] = q[i] + beta * z[i];
+            s[i] = w[i] + beta * s[i];
+            p[i] = r[i] + beta * p[i];
+            x[i] += alpha * p[i];
+            r[i] -= alpha * s[i];
+            w[i] -= alpha * z[i];
+        }
+        gamma_old = gamma;
+        alpha_old = alpha;
+        ++it;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return {it, std::chrono::duration<double>(end - start).count(), std::sqrt(rr / bb)};
+}
+
+// ||b - A x|| / ||b|| recomputed from scratch, and max |x - 1|.
+void check_solution(const Poisson& A, const std::vector<double>& b, std::vector<double>& x,
+                    double& true_residual, double& max_error) {
+    std::vector<double> Ax(A.extended(), 0.0), r(A.extended(), 0.0);
+    spmv(A, x, Ax);
+    double err = 0.0;
+    for (int i = A.n; i < A.n + A.owned(); ++i) {
+        r[i] = b[i] - Ax[i];
+        err = std::max(err, std::fabs(x[i] - 1.0));
+    }
+    true_residual = std::sqrt(global_dot(A, r, r) / global_dot(A, b, b));
+    MPI_Allreduce(&err, &max_error, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::vector<int> grid_sizes = {128, 256, 512, 1024};
+    int max_n = argc > 1 ? std::atoi(argv[1]) : grid_sizes.back();
+    std::vector<std::string> variants = {"classic", "pipelined"};
+
+    if (rank == 0) {
+        std::cout << "n,unknowns,proc_count,variant,iterations,time_sec,time_per_iter_sec,"
+                  << "rel_residual,true_rel_residual,max_error" << std::endl;
+    }
+
+    for (int n : grid_sizes) {
+        if (n > max_n || n < size) {
+            continue;
+        }
+        Poisson A = make_poisson(n, rank, size);
+        std::vector<double> ones(A.extended(), 1.0), b(A.extended(), 0.0);
+        spmv(A, ones, b);
+        int max_iters = 10 * n;
+
+        for (const auto& variant : variants) {
+            std::vector<double> x(A.extended(), 0.0);
+            CgResult res = variant == "classic" ? cg_classic(A, b, x, max_iters) : cg_pipelined(A, b, x, max_iters);
+
+            double true_residual, max_error;
+            check_solution(A, b, x, true_residual, max_error);
+
+            double time = res.time;
+            MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+            if (rank == 0) {
+                std::cout << n << "," << static_cast<long long>(n) * n << "," << size << "," << variant << ","
+                          << res.iterations << "," << time << "," << time / std::max(res.iterations, 1) << ","
+                          << res.residual << "," << true_residual << "," << max_error << std::endl;
+            }
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
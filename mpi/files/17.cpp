@@ -0,0 +1,321 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+
+// results/3.txt and 8.txt show a 1-byte message costing about as much as a
+// 1 KB one, so many tiny messages are dominated by per-message overhead. The
+// Aggregator below packs small messages per destination into one batch,
+// [tag][length][bytes] per record, and sends the batch as a single MPI
+// message once it reaches max_bytes or max_count, or on an explicit flush.
+// Receivers unpack batches and call the handler once per original message.
+
+const int TAG_RAW = 1;
+const int TAG_BATCH = 2;
+
+struct RecordHeader {
+    int tag;
+    int length;
+};
+
+class Aggregator {
+public:
+    typedef std::function<void(int source, int tag, const char* data, int length)> Handler;
+
+    Aggregator(MPI_Comm comm, size_t max_bytes, int max_count, Handler handler)
+        : comm_(comm), max_bytes_(max_bytes), max_count_(max_count), handler_(handler) {
+        int size;
+        MPI_Comm_size(comm_, &size);
+        outboxes_.resize(size);
+        batches_to_.assign(size, 0);
+    }
+
+    void send(int dest, int tag, const void* data, int length) {
+        Outbox& box = outboxes_[dest];
+        if (!box.buf.empty() && box.buf.size() + sizeof(RecordHeader) + length > max_bytes_) {
+            flush(dest);
+        }
+        RecordHeader header = {tag, length};
+        const char* h = reinterpret_cast<const char*>(&header);
+        const char* d = static_cast<const char*>(data);
+        box.buf.insert(box.buf.end(), h, h + sizeof(header));
+        box.buf.insert(box.buf.end(), d, d + length);
+        if (++box.count >= max_count_ || box.buf.size() >= max_bytes_) {
+            flush(dest);
+        }
+    }
+
+    void flush(int dest) {
+        Outbox& box = outboxes_[dest];
+        if (box.buf.empty()) {
+            return;
+        }
+        in_flight_.emplace_back();
+        InFlight& out = in_flight_.back();
+        out.buf.swap(box.buf);
+        box.buf.reserve(out.buf.capacity());
+        box.count = 0;
+        MPI_Isend(out.buf.data(), static_cast<int>(out.buf.size()), MPI_CHAR, dest, TAG_BATCH, comm_, &out.req);
+        ++batches_to_[dest];
+        ++batches_sent_;
+        progress();
+    }
+
+    void flush_all() {
+        for (size_t dest = 0; dest < outboxes_.size(); ++dest) {
+            flush(static_cast<int>(dest));
+        }
+    }
+
+    // Retires completed sends and dispatches every batch that has arrived.
+    void progress() {
+        in_flight_.erase(std::remove_if(in_flight_.begin(), in_flight_.end(), [](InFlight& f) {
+            int done = 0;
+            MPI_Test(&f.req, &done, MPI_STATUS_IGNORE);
+            return done != 0;
+        }), in_flight_.end());
+        while (receive_batch(false)) {
+        }
+    }
+
+    // Collective: flushes everything, then returns once every batch sent to
+    // this rank has been handled and every batch it sent has completed.
+    void finish() {
+        flush_all();
+        std::vector<long long> expected(batches_to_.size());
+        MPI_Alltoall(batches_to_.data(), 1, MPI_LONG_LONG, expected.data(), 1, MPI_LONG_LONG, comm_);
+        long long total = 0;
+        for (long long e : expected) {
+            total += e;
+        }
+        while (batches_received_ < total) {
+            receive_batch(true);
+        }
+        for (InFlight& f : in_flight_) {
+            MPI_Wait(&f.req, MPI_STATUS_IGNORE);
+        }
+        in_flight_.clear();
+    }
+
+    long long batches_sent() const { return batches_sent_; }
+
+private:
+    struct Outbox {
+        std::vector<char> buf;
+        int count = 0;
+    };
+    struct InFlight {
+        std::vector<char> buf;
+        MPI_Request req;
+    };
+
+    bool receive_batch(bool block) {
+        MPI_Status status;
+        if (block) {
+            MPI_Probe(MPI_ANY_SOURCE, TAG_BATCH, comm_, &status);
+        } else {
+            int flag = 0;
+            MPI_Iprobe(MPI_ANY_SOURCE, TAG_BATCH, comm_, &flag, &status);
+            if (!flag) {
+                return false;
+            }
+        }
+        int bytes;
+        MPI_Get_count(&status, MPI_CHAR, &bytes);
+        recv_buf_.resize(bytes);
+        MPI_Recv(recv_buf_.data(), bytes, MPI_CHAR, status.MPI_SOURCE, TAG_BATCH, comm_, MPI_STATUS_IGNORE);
+
+        for (size_t pos = 0; pos < recv_buf_.size();) {
+            RecordHeader header;
+            std::memcpy(&header, &recv_buf_[pos], sizeof(header));
+            pos += sizeof(header);
+            handler_(status.MPI_SOURCE, header.tag, &recv_buf_[pos], header.length);
+            pos += header.length;
+        }
+        ++batches_received_;
+        return true;
+    }
+
+    MPI_Comm comm_;
+    size_t max_bytes_;
+    int max_count_;
+    Handler handler_;
+    std::vector<Outbox> outboxes_;
+    std::vector<InFlight> in_flight_;
+    std::vector<long long> batches_to_;
+    std::vector<char> recv_buf_;
+    long long batches_sent_ = 0;
+    long long batches_received_ = 0;
+};
+
+// Message i of a rank goes to the other ranks in turn; its bytes encode the
+// sender and i so the receiver's checksum can be compared with the senders'.
+int destination(int rank, int size, int i) {
+    return size == 1 ? 0 : (rank + 1 + i % (size - 1)) % size;
+}
+
+// How many of the other ranks' messages are addressed to rank.
+int messages_to(int rank, int size, int num_msgs) {
+    if (size == 1) {
+        return num_msgs;
+    }
+    int total = 0;
+    for (int src = 0; src < size; ++src) {
+        if (src != rank) {
+            int k = (rank - src - 1 + size) % size;
+            total += num_msgs / (size - 1) + (k < num_msgs % (size - 1) ? 1 : 0);
+        }
+    }
+    return total;
+}
+
+void fill_message(std::vector<char>& msg, int rank, int i) {
+    for (size_t b = 0; b < msg.size(); ++b) {
+        msg[b] = static_cast<char>((rank * 31 + i + b) & 0x7f);
+    }
+}
+
+long long checksum(const char* data, int length) {
+    long long sum = 0;
+    for (int b = 0; b < length; ++b) {
+        sum += data[b];
+    }
+    return sum;
+}
+
+struct RunResult {
+    double time;
+    long long sent_sum, received_sum, received_count, batches;
+};
+
+// Every message as its own MPI_Isend; receives are drained while sending.
+RunResult run_raw(int msg_size, int num_msgs, int rank, int size) {
+    RunResult res = {0.0, 0, 0, 0, 0};
+    std::vector<char> recv(msg_size);
+    const int window = 1024;
+    std::vector<std::vector<char>> send_bufs(window, std::vector<char>(msg_size));
+    std::vector<MPI_Request> reqs(window, MPI_REQUEST_NULL);
+
+    auto drain = [&](bool block) {
+        MPI_Status status;
+        int flag = 1;
+        if (!block) {
+            MPI_Iprobe(MPI_ANY_SOURCE, TAG_RAW, MPI_COMM_WORLD, &flag, &status);
+        }
+        if (flag) {
+            MPI_Recv(recv.data(), msg_size, MPI_CHAR, MPI_ANY_SOURCE, TAG_RAW, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            res.received_sum += checksum(recv.data(), msg_size);
+            ++res.received_count;
+        }
+        return flag != 0;
+    };
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < num_msgs; ++i) {
+        int slot = i % window;
+        if (reqs[slot] != MPI_REQUEST_NULL) {
+            int done = 0;
+            while (!done) {
+                MPI_Test(&reqs[slot], &done, MPI_STATUS_IGNORE);
+                if (!done) {
+                    drain(false);
+                }
+            }
+        }
+        fill_message(send_bufs[slot], rank, i);
+        res.sent_sum += checksum(send_bufs[slot].data(), msg_size);
+        MPI_Isend(send_bufs[slot].data(), msg_size, MPI_CHAR, destination(rank, size, i), TAG_RAW, MPI_COMM_WORLD, &reqs[slot]);
+        while (drain(false)) {
+        }
+    }
+    int expected = messages_to(rank, size, num_msgs);
+    while (res.received_count < expected) {
+        drain(true);
+    }
+    MPI_Waitall(window, reqs.data(), MPI_STATUSES_IGNORE);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    res.time = std::chrono::duration<double>(end - start).count();
+    res.batches = num_msgs;
+    return res;
+}
+
+RunResult run_aggregated(int msg_size, int num_msgs, size_t max_bytes, int max_count, int rank, int size) {
+    RunResult res = {0.0, 0, 0, 0, 0};
+    std::vector<char> msg(msg_size);
+    Aggregator agg(MPI_COMM_WORLD, max_bytes, max_count, [&](int, int, const char* data, int length) {
+        res.received_sum += checksum(data, length);
+        ++res.received_count;
+    });
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < num_msgs; ++i) {
+        fill_message(msg, rank, i);
+        res.sent_sum += checksum(msg.data(), msg_size);
+        agg.send(destination(rank, size, i), 0, msg.data(), msg_size);
+    }
+    agg.finish();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    res.time = std::chrono::duration<double>(end - start).count();
+    res.batches = agg.batches_sent();
+    return res;
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int num_msgs = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::vector<int> msg_sizes = {1, 10, 100};
+    struct Threshold {
+        size_t bytes;
+        int count;
+    };
+    std::vector<Threshold> thresholds = {{1024, 64}, {8192, 512}, {65536, 4096}};
+
+    if (rank == 0) {
+        std::cout << "msg_size,proc_count,msgs_per_rank,mode,max_batch_bytes,max_batch_msgs,time_sec,"
+                  << "msgs_per_sec,batches_per_rank,correct" << std::endl;
+    }
+
+    for (int msg_size : msg_sizes) {
+        for (int t = -1; t < static_cast<int>(thresholds.size()); ++t) {
+            RunResult res = t < 0 ? run_raw(msg_size, num_msgs, rank, size)
+                                  : run_aggregated(msg_size, num_msgs, thresholds[t].bytes, thresholds[t].count, rank, size);
+
+            long long local[4] = {res.sent_sum, res.received_sum, res.received_count, res.batches};
+            long long global[4];
+            MPI_Reduce(local, global, 4, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+            double time = 0.0;
+            MPI_Reduce(&res.time, &time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+            if (rank == 0) {
+                bool ok = global[0] == global[1] && global[2] == static_cast<long long>(num_msgs) * size;
+                std::cout << msg_size << "," << size << "," << num_msgs << ",";
+                if (t < 0) {
+                    std::cout << "raw,n/a,n/a,";
+                } else {
+                    std::cout << "aggregated," << thresholds[t].bytes << "," << thresholds[t].count << ",";
+                }
+                std::cout << time << "," << static_cast<double>(num_msgs) * size / time << ","
+                          << global[3] / size << "," << (ok ? "Yes" : "No") << std::endl;
+            }
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include "file_input.h"
+
+// Input bandwidth of rank 0 reading a file and scattering it, against every
+// rank reading its own block with collective MPI-IO (file_input.h). Two
+// layouts: a vector (one row of the file, split into element blocks) and a
+// matrix split into row blocks, where the file view skips the row padding.
+// Rank 0 writes the inputs first; before each read the file is dropped from
+// the page cache with posix_fadvise so both paths go to the disk.
+//
+//   ./18 [dir=.] [max_elements=100000000]
+
+const int matrix_cols = 1000;
+
+void drop_cache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+bool read_full(int fd, char* buf, size_t bytes, off_t offset) {
+    while (bytes > 0) {
+        ssize_t got = pread(fd, buf, bytes, offset);
+        if (got <= 0) {
+            return false;
+        }
+        buf += got;
+        bytes -= got;
+        offset += got;
+    }
+    return true;
+}
+
+// Rank 0 preads rows [0, rows) whole and scatters counts[r] units to each
+// rank: single elements for a vector, or rows of unit_len elements spaced
+// unit_stride apart for a matrix, whose padding is dropped by send_type.
+void root_read_scatter(const std::string& path, const DatasetHeader& h, long long rows,
+                       const std::vector<int>& counts, const std::vector<int>& displs,
+                       MPI_Datatype send_type, int unit_len, long long unit_stride,
+                       int rank, std::vector<int>& local, int local_count) {
+    std::vector<int> all;
+    if (rank == 0) {
+        all.resize(rows * h.stride);
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0 || !read_full(fd, reinterpret_cast<char*>(all.data()), all.size() * sizeof(int), h.data_offset)) {
+            std::cerr << "Failed to read " << path << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        close(fd);
+
+        // With MPI_IN_PLACE at the root, Scatterv leaves the root's block where
+        // it is in the send buffer, so rank 0 copies it out (dropping the row
+        // padding) itself.
+        for (int u = 0; u < counts[0]; ++u) {
+            const int* src = all.data() + u * unit_stride;
+            std::copy(src, src + unit_len, local.data() + static_cast<size_t>(u) * unit_len);
+        }
+        MPI_Scatterv(all.data(), counts.data(), displs.data(), send_type, MPI_IN_PLACE, local_count, MPI_INT, 0, MPI_COMM_WORLD);
+    } else {
+        MPI_Scatterv(nullptr, nullptr, nullptr, send_type, local.data(), local_count, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+}
+
+double max_time(double local) {
+    double slowest = 0.0;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return slowest;
+}
+
+bool all_ranks_agree(bool local_ok) {
+    int ok = local_ok ? 1 : 0, all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return all_ok != 0;
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::string dir = argc > 1 ? argv[1] : ".";
+    long long max_elements = argc > 2 ? std::atoll(argv[2]) : 100000000;
+    std::vector<long long> element_counts = {1000000, 10000000, 100000000};
+
+    if (rank == 0) {
+        std::cout << "layout,elements,bytes,proc_count,root_scatter_time,collective_time,"
+                  << "root_scatter_GBps,collective_GBps,correct" << std::endl;
+    }
+
+    for (long long elements : element_counts) {
+        if (elements > max_elements) {
+            continue;
+        }
+        for (const std::string layout : {"vector", "matrix"}) {
+            bool is_vector = layout == "vector";
+            long long rows = is_vector ? 1 : elements / matrix_cols;
+            long long cols = is_vector ? elements : matrix_cols;
+            std::string path = dir + "/18_input_" + layout + ".bin";
+
+            if (rank == 0) {
+                bool ok = dataset_write<int>(path, rows, cols, [&](size_t i, int* row) {
+                    for (long long j = 0; j < cols; j++) {
+                        row[j] = static_cast<int>((i * cols + j) % 1000003);
+                    }
+                });
+                if (!ok) {
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            FileInput input;
+            if (!file_input_open(path.c_str(), input, MPI_COMM_WORLD)) {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            const DatasetHeader& h = input.header;
+
+            // Per-rank blocks: elements of the vector, or whole matrix rows.
+            long long units = is_vector ? cols : rows;
+            std::vector<int> counts(size), displs(size);
+            for (int r = 0; r < size; ++r) {
+                displs[r] = static_cast<int>(file_block_start(r, units, size));
+                counts[r] = static_cast<int>(file_block_start(r + 1, units, size)) - displs[r];
+            }
+            int local_units = counts[rank];
+            int local_count = is_vector ? local_units : local_units * static_cast<int>(cols);
+
+            MPI_Datatype send_type = MPI_INT, line = MPI_DATATYPE_NULL;
+            if (!is_vector) {
+                MPI_Type_contiguous(static_cast<int>(cols), MPI_INT, &line);
+                MPI_Type_create_resized(line, 0, static_cast<MPI_Aint>(h.stride * sizeof(int)), &send_type);
+                MPI_Type_commit(&send_type);
+            }
+
+            std::vector<int> scattered(local_count), collective(local_count);
+
+            if (rank == 0) {
+                drop_cache(path);
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+            auto start = std::chrono::high_resolution_clock::now();
+            root_read_scatter(path, h, rows, counts, displs, send_type, is_vector ? 1 : static_cast<int>(cols),
+                              is_vector ? 1 : static_cast<long long>(h.stride), rank, scattered, local_count);
+            auto end = std::chrono::high_resolution_clock::now();
+            double scatter_time = max_time(std::chrono::duration<double>(end - start).count());
+
+            if (rank == 0) {
+                drop_cache(path);
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = std::chrono::high_resolution_clock::now();
+            if (is_vector) {
+                file_input_read_slice(input, 0, displs[rank], local_count, collective.data());
+            } else {
+                file_input_read_rows(input, displs[rank], local_units, collective.data());
+            }
+            end = std::chrono::high_resolution_clock::now();
+            double collective_time = max_time(std::chrono::duration<double>(end - start).count());
+
+            bool correct = scattered == collective;
+            long long first = is_vector ? displs[rank] : static_cast<long long>(displs[rank]) * cols;
+            for (int k = 0; k < local_count && correct; ++k) {
+                correct = collective[k] == static_cast<int>((first + k) % 1000003);
+            }
+            correct = all_ranks_agree(correct);
+
+            if (!is_vector) {
+                MPI_Type_free(&send_type);
+                MPI_Type_free(&line);
+            }
+            file_input_close(input);
+
+            if (rank == 0) {
+                double bytes = static_cast<double>(rows * cols) * sizeof(int);
+                std::cout << layout << "," << rows * cols << "," << static_cast<long long>(bytes) << "," << size << ","
+                          << scatter_time << "," << collective_time << ","
+                          << bytes / scatter_time / 1e9 << "," << bytes / collective_time / 1e9 << ","
+                          << (correct ? "Yes" : "No") << std::endl;
+                std::remove(path.c_str());
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
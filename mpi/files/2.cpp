@@ -2,21 +2,24 @@
 #include <iostream>
 #include <vector>
 #include <numeric>
+#include <cstdlib>
+#include <ctime>
 #include <chrono>
+#include "shared_input.h"
+#include "file_input.h"
 
 long long seq_dot_prod(const std::vector<int>& v1, const std::vector<int>& v2) {
     return std::inner_product(v1.begin(), v1.end(), v2.begin(), 0LL);
 }
 
-long long par_dot_prod(const std::vector<int>& v1, const std::vector<int>& v2, int rank, int size) {
-    int N = v1.size();
-    int local_N = N / size;
+long long par_dot_prod(const std::vector<int>& v1, const std::vector<int>& v2, int local_N, long& mem_kb) {
     std::vector<int> local_v1(local_N), local_v2(local_N);
 
     MPI_Scatter(v1.data(), local_N, MPI_INT, local_v1.data(), local_N, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Scatter(v2.data(), local_N, MPI_INT, local_v2.data(), local_N, MPI_INT, 0, MPI_COMM_WORLD);
 
     long long local_res = std::inner_product(local_v1.begin(), local_v1.end(), local_v2.begin(), 0LL);
+    mem_kb = resident_kb();
 
     long long global_res = 0;
     MPI_Reduce(&local_res, &global_res, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
@@ -24,6 +27,66 @@ long long par_dot_prod(const std::vector<int>& v1, const std::vector<int>& v2, i
     return global_res;
 }
 
+// Same product over slices read in place from the node's shared window.
+long long shared_dot_prod(SharedInput& input, int local_N, long& mem_kb) {
+    shared_input_distribute(input, local_N);
+
+    const int* local_v1 = shared_input_slice(input, 0, local_N);
+    const int* local_v2 = shared_input_slice(input, 1, local_N);
+    long long local_res = std::inner_product(local_v1, local_v1 + local_N, local_v2, 0LL);
+    mem_kb = resident_kb();
+
+    long long global_res = 0;
+    MPI_Reduce(&local_res, &global_res, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    return global_res;
+}
+
+// ./2 <dataset>: each rank reads its own blocks of rows 0 and 1 of the file
+// with collective MPI-IO instead of receiving them from rank 0.
+int run_file_input(const char* path, int rank, int size) {
+    FileInput input;
+    if (!file_input_open(path, input, MPI_COMM_WORLD)) {
+        return 1;
+    }
+    if (input.header.rows < 2) {
+        if (rank == 0) {
+            std::cerr << path << " must hold two vectors (rows = 2)" << std::endl;
+        }
+        file_input_close(input);
+        return 1;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto read_start = std::chrono::high_resolution_clock::now();
+    std::vector<int> local_v1 = file_input_read_block(input, 0, MPI_COMM_WORLD);
+    std::vector<int> local_v2 = file_input_read_block(input, 1, MPI_COMM_WORLD);
+    auto read_end = std::chrono::high_resolution_clock::now();
+    double read_time = std::chrono::duration<double>(read_end - read_start).count();
+    file_input_close(input);
+
+    long long local_res = std::inner_product(local_v1.begin(), local_v1.end(), local_v2.begin(), 0LL);
+    long long global_res = 0;
+    MPI_Reduce(&local_res, &global_res, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : &read_time, &read_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        long long N = static_cast<long long>(input.header.cols);
+        std::cout << "vec_size,proc_count,read_time,read_GBps,result\n";
+        std::cout << N << "," << size << "," << read_time << ","
+                  << 2 * N * sizeof(int) / read_time / 1e9 << "," << global_res << "\n";
+    }
+    return 0;
+}
+
+void fill_random(int* v1, int* v2, int N, unsigned seed) {
+    std::srand(seed);
+    for (int i = 0; i < N; ++i) {
+        v1[i] = std::rand() % 1000;
+        v2[i] = std::rand() % 1000;
+    }
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
 
@@ -31,43 +94,78 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    if (argc > 1) {
+        int status = run_file_input(argv[1], rank, size);
+        MPI_Finalize();
+        return status;
+    }
+
     std::vector<int> vec_sizes = {1000, 10000, 100000, 1000000, 10000000};
 
     if (rank == 0) {
-        std::cout << "vec_size,proc_count,seq_time,par_time,result\n";
+        std::cout << "vec_size,proc_count,seq_time,par_time,shared_time,par_mem_mb,shared_mem_mb,result,shared_result\n";
     }
 
     for (int N : vec_sizes) {
-        std::vector<int> v1, v2;
-        if (rank == 0) {
-            v1.resize(N);
-            v2.resize(N);
-            std::srand(static_cast<unsigned>(std::time(0)));
-            for (int i = 0; i < N; ++i) {
-                v1[i] = std::rand() % 1000;
-                v2[i] = std::rand() % 1000;
+        int local_N = N / size;
+        unsigned seed = static_cast<unsigned>(std::time(0));
+
+        // Memory columns are the growth in resident memory summed over ranks,
+        // sampled while the inputs and the local slices are live.
+        std::chrono::duration<double> seq_time(0.0), par_time(0.0);
+        long long global_res = 0;
+        long base_kb = resident_kb(), par_kb = 0;
+        {
+            std::vector<int> v1, v2;
+            if (rank == 0) {
+                v1.resize(N);
+                v2.resize(N);
+                fill_random(v1.data(), v2.data(), N, seed);
             }
+
+            auto seq_start = std::chrono::high_resolution_clock::now();
+            long long seq_res = 0;
+            if (rank == 0) {
+                seq_res = seq_dot_prod(v1, v2);
+            }
+            auto seq_end = std::chrono::high_resolution_clock::now();
+            seq_time = seq_end - seq_start;
+
+            auto par_start = std::chrono::high_resolution_clock::now();
+            global_res = par_dot_prod(v1, v2, local_N, par_kb);
+            auto par_end = std::chrono::high_resolution_clock::now();
+            par_time = par_end - par_start;
         }
+        long par_delta = par_kb - base_kb, par_total = 0;
+        MPI_Reduce(&par_delta, &par_total, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
-        auto seq_start = std::chrono::high_resolution_clock::now();
-        long long seq_res = 0;
+        base_kb = resident_kb();
+        long shared_kb = 0;
+        SharedInput input = shared_input_create(N, local_N, 2, rank);
         if (rank == 0) {
-            seq_res = seq_dot_prod(v1, v2);
+            fill_random(shared_input_root_array(input, 0), shared_input_root_array(input, 1), N, seed);
         }
-        auto seq_end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> seq_time = seq_end - seq_start;
 
-        auto par_start = std::chrono::high_resolution_clock::now();
-        long long global_res = par_dot_prod(v1, v2, rank, size);
-        auto par_end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> par_time = par_end - par_start;
+        MPI_Barrier(MPI_COMM_WORLD);
+        auto shared_start = std::chrono::high_resolution_clock::now();
+        long long shared_res = shared_dot_prod(input, local_N, shared_kb);
+        auto shared_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> shared_time = shared_end - shared_start;
+        shared_input_free(input);
+
+        long shared_delta = shared_kb - base_kb, shared_total = 0;
+        MPI_Reduce(&shared_delta, &shared_total, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
         if (rank == 0) {
             std::cout << N << ","
                       << size << ","
                       << seq_time.count() << ","
                       << par_time.count() << ","
-                      << global_res << "\n";
+                      << shared_time.count() << ","
+                      << par_total / 1024.0 << ","
+                      << shared_total / 1024.0 << ","
+                      << global_res << ","
+                      << shared_res << "\n";
         }
     }
 
@@ -3,6 +3,7 @@
 #include <vector>
 #include <cstring>
 #include <chrono>
+#include "buffer_pool.h"
 
 void exchange_msgs(int rk, int msg_size, int num_exch) {
     char* snd_buf = new char[msg_size];
@@ -24,6 +25,23 @@ void exchange_msgs(int rk, int msg_size, int num_exch) {
     delete[] rcv_buf;
 }
 
+// Same exchange with buffers leased from the pool: no allocation or memset
+// once the pool holds a block of this size.
+void exchange_msgs_pooled(int rk, int msg_size, int num_exch) {
+    BufferLease snd_buf = buffer_pool().acquire(msg_size);
+    BufferLease rcv_buf = buffer_pool().acquire(msg_size);
+
+    for (int i = 0; i < num_exch; ++i) {
+        if (rk == 0) {
+            MPI_Send(snd_buf.data(), msg_size, MPI_CHAR, 1, 0, MPI_COMM_WORLD);
+            MPI_Recv(rcv_buf.data(), msg_size, MPI_CHAR, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        } else if (rk == 1) {
+            MPI_Recv(rcv_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(snd_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
 
@@ -32,27 +50,46 @@ int main(int argc, char** argv) {
     MPI_Comm_size(MPI_COMM_WORLD, &sz);
 
     std::vector<int> msg_sizes = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    const int num_exch = 10;
+    const int num_rounds = 20;
 
     if (rk == 0) {
-        std::cout << "Размер сообщения (байт),Среднее время обмена (сек)\n";
+        std::cout << "Размер сообщения (байт),Среднее время обмена (сек),"
+                  << "Среднее время с пулом буферов (сек),Выигрыш на обмен (сек)\n";
     }
 
     for (int msg_size : msg_sizes) {
-        MPI_Barrier(MPI_COMM_WORLD);
+        // One untimed call of each variant sets up the connection and fills
+        // the pool for this size class; the two are then timed in
+        // alternating rounds so neither is measured cold.
+        exchange_msgs(rk, msg_size, 1);
+        exchange_msgs_pooled(rk, msg_size, 1);
 
-        auto start = std::chrono::high_resolution_clock::now();
+        double total_time = 0.0, pooled_time = 0.0;
+        for (int r = 0; r < num_rounds; ++r) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            auto start = std::chrono::high_resolution_clock::now();
+            exchange_msgs(rk, msg_size, num_exch);
+            auto end = std::chrono::high_resolution_clock::now();
+            total_time += std::chrono::duration<double>(end - start).count();
 
-        exchange_msgs(rk, msg_size, 10);
-
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> total_time = end - start;
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = std::chrono::high_resolution_clock::now();
+            exchange_msgs_pooled(rk, msg_size, num_exch);
+            end = std::chrono::high_resolution_clock::now();
+            pooled_time += std::chrono::duration<double>(end - start).count();
+        }
 
         if (rk == 0) {
-            std::cout << msg_size << "," 
-                      << total_time.count() / 10 << "\n";
+            int exchanges = num_rounds * num_exch;
+            std::cout << msg_size << ","
+                      << total_time / exchanges << ","
+                      << pooled_time / exchanges << ","
+                      << (total_time - pooled_time) / exchanges << "\n";
         }
     }
 
+    buffer_pool().clear();
     MPI_Finalize();
     return 0;
 }
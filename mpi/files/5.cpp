@@ -2,34 +2,136 @@
 #include <iostream>
 #include <unistd.h>
 #include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <chrono>
+#include "buffer_pool.h"
+
+const int TAG_REQUEST = 1;
+const int TAG_ASSIGN = 2;
+
+struct FarmStats {
+    double exec_time;
+    double master_idle;
+    double busy_time;
+};
 
 void do_computations(int delay_us) {
     usleep(delay_us);
 }
 
-void send_receive(int msg_size, int rank, int size, int transfers) {
-    std::vector<char> send_buf(msg_size, rank);
-    std::vector<char> recv_buf(msg_size, 0);
+// Splits total_us of work into num_tasks items. "uniform" gives equal items,
+// "linear" a ramp where the last item is num_tasks times the first, and
+// "random" skewed costs from a fixed seed so that every rank builds the same list.
+std::vector<int> make_task_costs(const std::string& profile, int num_tasks, int total_us) {
+    std::vector<double> weights(num_tasks, 1.0);
+    if (profile == "linear") {
+        for (int i = 0; i < num_tasks; ++i) {
+            weights[i] = i + 1;
+        }
+    } else if (profile == "random") {
+        std::srand(12345);
+        for (int i = 0; i < num_tasks; ++i) {
+            double r = (std::rand() % 1000 + 1) / 1000.0;
+            weights[i] = r * r * r;
+        }
+    }
 
-    if (rank == 0) {
-        for (int i = 1; i < size; i++) {
-            MPI_Send(send_buf.data(), msg_size, MPI_CHAR, i, 0, MPI_COMM_WORLD);
+    double weight_sum = 0.0;
+    for (double w : weights) {
+        weight_sum += w;
+    }
+
+    std::vector<int> costs(num_tasks);
+    for (int i = 0; i < num_tasks; ++i) {
+        costs[i] = static_cast<int>(total_us * weights[i] / weight_sum);
+    }
+    return costs;
+}
+
+// Guided self-scheduling: hand out half of an even share of what is left,
+// so early chunks are large and the tail is made of single items.
+int next_chunk(int remaining, int n_workers) {
+    int chunk = (remaining + 2 * n_workers - 1) / (2 * n_workers);
+    return std::max(1, std::min(chunk, remaining));
+}
+
+FarmStats run_master(int msg_size, int size, int num_tasks) {
+    FarmStats stats = {0.0, 0.0, 0.0};
+    int n_workers = size - 1;
+    int header_size = 2 * sizeof(int);
+    BufferLease assign_buf = buffer_pool().acquire(header_size + msg_size, true);
+    BufferLease result_buf = buffer_pool().acquire(msg_size);
+
+    int next_task = 0;
+    int stopped = 0;
+    while (stopped < n_workers) {
+        MPI_Status status;
+        auto idle_start = std::chrono::high_resolution_clock::now();
+        MPI_Recv(result_buf.data(), msg_size, MPI_CHAR, MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &status);
+        auto idle_end = std::chrono::high_resolution_clock::now();
+        stats.master_idle += std::chrono::duration<double>(idle_end - idle_start).count();
+
+        int header[2] = {next_task, 0};
+        int payload = 0;
+        if (next_task < num_tasks) {
+            header[1] = next_chunk(num_tasks - next_task, n_workers);
+            next_task += header[1];
+            payload = msg_size;
+        } else {
+            ++stopped;
         }
+        std::memcpy(assign_buf.data(), header, header_size);
+        MPI_Send(assign_buf.data(), header_size + payload, MPI_BYTE, status.MPI_SOURCE, TAG_ASSIGN, MPI_COMM_WORLD);
+    }
+    return stats;
+}
 
-        for (int t = 0; t < transfers; t++) {
-            for (int i = 1; i < size; i++) {
-                MPI_Recv(recv_buf.data(), msg_size, MPI_CHAR, i, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            }
+FarmStats run_worker(int msg_size, int rank, const std::vector<int>& costs) {
+    FarmStats stats = {0.0, 0.0, 0.0};
+    int header_size = 2 * sizeof(int);
+    BufferLease assign_buf = buffer_pool().acquire(header_size + msg_size, true);
+    BufferLease result_buf = buffer_pool().acquire(msg_size);
+    std::memset(result_buf.data(), rank, msg_size);
+
+    int result_size = 0;
+    while (true) {
+        MPI_Send(result_buf.data(), result_size, MPI_CHAR, 0, TAG_REQUEST, MPI_COMM_WORLD);
+        MPI_Recv(assign_buf.data(), header_size + msg_size, MPI_BYTE, 0, TAG_ASSIGN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        int header[2];
+        std::memcpy(header, assign_buf.data(), header_size);
+        if (header[1] == 0) {
+            break;
         }
-    } else {
-        MPI_Recv(recv_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        do_computations(1000 / size);
 
-        for (int t = 0; t < transfers; t++) {
-            MPI_Send(send_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD);
+        auto busy_start = std::chrono::high_resolution_clock::now();
+        for (int t = header[0]; t < header[0] + header[1]; ++t) {
+            do_computations(costs[t]);
         }
+        auto busy_end = std::chrono::high_resolution_clock::now();
+        stats.busy_time += std::chrono::duration<double>(busy_end - busy_start).count();
+        result_size = msg_size;
+    }
+    return stats;
+}
+
+FarmStats task_farm(int msg_size, int rank, int size, const std::vector<int>& costs) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    FarmStats stats;
+    if (rank == 0) {
+        stats = run_master(msg_size, size, static_cast<int>(costs.size()));
+    } else {
+        stats = run_worker(msg_size, rank, costs);
     }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.exec_time = std::chrono::duration<double>(end - start).count();
+    return stats;
 }
 
 int main(int argc, char** argv) {
@@ -39,30 +141,59 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    if (size < 2) {
+        if (rank == 0) {
+            std::cerr << "Task farm needs at least 2 processes\n";
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    std::vector<std::string> profiles = {"uniform", "linear", "random"};
+    if (argc > 1) {
+        profiles = {argv[1]};
+    }
+    int num_tasks = argc > 2 ? std::atoi(argv[2]) : 32 * (size - 1);
+
     std::vector<int> delays = {1000, 10000, 100000, 1000000};
     std::vector<int> msg_sizes = {1024, 10240, 102400, 1048576};
 
     if (rank == 0) {
-        std::cout << "delay_us,msg_size_bytes,exec_time_sec\n";
+        std::cout << "delay_us,cost_profile,msg_size_bytes,proc_count,exec_time_sec,master_idle_sec,worker_util_avg,worker_util_min\n";
     }
 
     for (int delay : delays) {
-        for (int msg_size : msg_sizes) {
-            auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& profile : profiles) {
+            std::vector<int> costs = make_task_costs(profile, num_tasks, delay);
 
-            send_receive(msg_size, rank, size);
+            for (int msg_size : msg_sizes) {
+                FarmStats stats = task_farm(msg_size, rank, size, costs);
 
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> exec_time = end - start;
+                double util = 0.0;
+                if (rank != 0 && stats.exec_time > 0.0) {
+                    util = stats.busy_time / stats.exec_time;
+                }
+                double util_for_min = rank == 0 ? 1.0 : util;
+                double util_sum = 0.0;
+                double util_min = 0.0;
+                MPI_Reduce(&util, &util_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+                MPI_Reduce(&util_for_min, &util_min, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
 
-            if (rank == 0) {
-                std::cout << delay << ","
-                          << msg_size << ","
-                          << exec_time.count() << "\n";
+                if (rank == 0) {
+                    std::cout << delay << ","
+                              << profile << ","
+                              << msg_size << ","
+                              << size << ","
+                              << stats.exec_time << ","
+                              << stats.master_idle << ","
+                              << util_sum / (size - 1) << ","
+                              << util_min << "\n";
+                }
             }
         }
     }
 
+    buffer_pool().clear();
     MPI_Finalize();
     return 0;
 }
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
+#include "file_input.h"
 
 int dot_product_simple(const std::vector<int>& A, const std::vector<int>& B, int N) {
     int result = 0;
@@ -33,6 +34,49 @@ bool verify_result(int seq_result, int parallel_result) {
     return seq_result == parallel_result;
 }
 
+// ./6 <dataset>: rows 0 and 1 of the file are A and B; each rank reads its
+// own blocks with collective MPI-IO instead of receiving them from rank 0.
+int run_file_input(const char* path, int rank, int size) {
+    FileInput input;
+    if (!file_input_open(path, input, MPI_COMM_WORLD)) {
+        return 1;
+    }
+    if (input.header.rows < 2) {
+        if (rank == 0) {
+            std::cerr << path << " must hold two vectors (rows = 2)" << std::endl;
+        }
+        file_input_close(input);
+        return 1;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<int> local_A = file_input_read_block(input, 0, MPI_COMM_WORLD);
+    std::vector<int> local_B = file_input_read_block(input, 1, MPI_COMM_WORLD);
+    auto read_end = std::chrono::high_resolution_clock::now();
+    file_input_close(input);
+
+    long long local_result = 0;
+    for (size_t i = 0; i < local_A.size(); ++i) {
+        local_result += static_cast<long long>(local_A[i]) * local_B[i];
+    }
+    long long global_result = 0;
+    MPI_Reduce(&local_result, &global_result, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    double times[2] = {std::chrono::duration<double>(read_end - start_time).count(),
+                       std::chrono::duration<double>(end_time - start_time).count()};
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : times, times, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        long long N = static_cast<long long>(input.header.cols);
+        std::cout << "vec_size,num_procs,read_time,read_GBps,exec_time,result\n";
+        std::cout << N << "," << size << "," << times[0] << "," << 2 * N * sizeof(int) / times[0] / 1e9 << ","
+                  << times[1] << "," << global_result << "\n";
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
 
@@ -40,6 +84,12 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    if (argc > 1) {
+        int status = run_file_input(argv[1], rank, size);
+        MPI_Finalize();
+        return status;
+    }
+
     std::vector<int> vec_sizes = {10000, 100000, 1000000};
     std::vector<std::string> modes = {"synchronous", "ready", "buffered"};
 
@@ -1,34 +1,142 @@
 #include <mpi.h>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <unistd.h>
 #include <chrono>
+#include <cstring>
+#include "buffer_pool.h"
 
-void do_computations(int delay_us) {
-    usleep(delay_us);
+const int num_chunks = 8;
+const int poll_slice_us = 100;
+
+struct PipelineStats {
+    double exec_time;
+    double wait_time;
+};
+
+// Sleeps for delay_us, waking up every poll_slice_us to let MPI progress the
+// transfers that are in flight (rendezvous messages only move inside MPI calls).
+void do_computations(int delay_us, MPI_Request* reqs, int n_reqs) {
+    while (delay_us > 0) {
+        int slice = std::min(delay_us, poll_slice_us);
+        usleep(slice);
+        delay_us -= slice;
+
+        int flag;
+        MPI_Testall(n_reqs, reqs, &flag, MPI_STATUSES_IGNORE);
+    }
 }
 
-void send_data(int msg_size, int rank, int size) {
-    std::vector<char> send_buf(msg_size, rank);
-    MPI_Request req;
-    for (int i = 1; i < size; ++i) {
-        MPI_Isend(send_buf.data(), msg_size, MPI_CHAR, i, 0, MPI_COMM_WORLD, &req);
-        MPI_Wait(&req, MPI_STATUS_IGNORE);
+void chunk_bounds(int msg_size, int k, int& offset, int& count) {
+    int base = msg_size / num_chunks;
+    int rest = msg_size % num_chunks;
+    offset = k * base + std::min(k, rest);
+    count = base + (k < rest ? 1 : 0);
+}
+
+double wait_timed(MPI_Request* req) {
+    auto start = std::chrono::high_resolution_clock::now();
+    MPI_Wait(req, MPI_STATUS_IGNORE);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Rank 0: every chunk send and every result receive is posted before anything
+// is waited on, then completions are drained with MPI_Waitsome.
+void master_pipeline(int msg_size, int size, char* send_buf, char* recv_buf) {
+    int n_workers = size - 1;
+    std::vector<MPI_Request> reqs(2 * n_workers * num_chunks, MPI_REQUEST_NULL);
+
+    int r = 0;
+    for (int w = 1; w < size; ++w) {
+        char* worker_recv = recv_buf + static_cast<size_t>(w - 1) * msg_size;
+        for (int k = 0; k < num_chunks; ++k) {
+            int offset, count;
+            chunk_bounds(msg_size, k, offset, count);
+            MPI_Irecv(worker_recv + offset, count, MPI_CHAR, w, k, MPI_COMM_WORLD, &reqs[r++]);
+        }
+    }
+    for (int k = 0; k < num_chunks; ++k) {
+        int offset, count;
+        chunk_bounds(msg_size, k, offset, count);
+        for (int w = 1; w < size; ++w) {
+            MPI_Isend(send_buf + offset, count, MPI_CHAR, w, k, MPI_COMM_WORLD, &reqs[r++]);
+        }
+    }
+
+    std::vector<int> indices(reqs.size());
+    int remaining = static_cast<int>(reqs.size());
+    while (remaining > 0) {
+        int done;
+        MPI_Waitsome(static_cast<int>(reqs.size()), reqs.data(), &done, indices.data(), MPI_STATUSES_IGNORE);
+        if (done == MPI_UNDEFINED) {
+            break;
+        }
+        remaining -= done;
     }
 }
 
-void receive_data(int msg_size, int rank) {
-    std::vector<char> recv_buf(msg_size, 0);
-    MPI_Request req;
-    MPI_Irecv(recv_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &req);
-    MPI_Wait(&req, MPI_STATUS_IGNORE);
+// Worker: chunk k+1 is received into the other half of a double buffer while
+// chunk k is being computed on, and results go back with Isend.
+double worker_pipeline(int msg_size, int delay_us, char* in_buf, char* out_buf) {
+    int max_chunk = (msg_size + num_chunks - 1) / num_chunks;
+    char* in[2] = {in_buf, in_buf + max_chunk};
+    char* out[2] = {out_buf, out_buf + max_chunk};
+    MPI_Request recv_req[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    MPI_Request send_req[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    int chunk_delay = delay_us / num_chunks;
+    double wait_time = 0.0;
+
+    int offset, count;
+    chunk_bounds(msg_size, 0, offset, count);
+    MPI_Irecv(in[0], count, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &recv_req[0]);
+
+    for (int k = 0; k < num_chunks; ++k) {
+        int cur = k % 2;
+        int next = 1 - cur;
+        wait_time += wait_timed(&recv_req[cur]);
+
+        if (k + 1 < num_chunks) {
+            int next_offset, next_count;
+            chunk_bounds(msg_size, k + 1, next_offset, next_count);
+            MPI_Irecv(in[next], next_count, MPI_CHAR, 0, k + 1, MPI_COMM_WORLD, &recv_req[next]);
+        }
+        wait_time += wait_timed(&send_req[cur]);
+
+        chunk_bounds(msg_size, k, offset, count);
+        for (int i = 0; i < count; ++i) {
+            out[cur][i] = in[cur][i] + 1;
+        }
+        MPI_Request in_flight[2] = {recv_req[next], send_req[next]};
+        do_computations(chunk_delay, in_flight, 2);
+        recv_req[next] = in_flight[0];
+        send_req[next] = in_flight[1];
+
+        MPI_Isend(out[cur], count, MPI_CHAR, 0, k, MPI_COMM_WORLD, &send_req[cur]);
+    }
+
+    wait_time += wait_timed(&send_req[0]);
+    wait_time += wait_timed(&send_req[1]);
+    return wait_time;
 }
 
-void send_back_data(int msg_size, int rank) {
-    std::vector<char> send_buf(msg_size, rank);
-    MPI_Request req;
-    MPI_Isend(send_buf.data(), msg_size, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &req);
-    MPI_Wait(&req, MPI_STATUS_IGNORE);
+PipelineStats run_pipeline(int msg_size, int delay_us, int rank, int size,
+                           char* buf_a, char* buf_b) {
+    PipelineStats stats = {0.0, 0.0};
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (rank == 0) {
+        master_pipeline(msg_size, size, buf_a, buf_b);
+    } else {
+        stats.wait_time = worker_pipeline(msg_size, delay_us, buf_a, buf_b);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.exec_time = std::chrono::duration<double>(end - start).count();
+    return stats;
 }
 
 int main(int argc, char** argv) {
@@ -42,35 +150,49 @@ int main(int argc, char** argv) {
     std::vector<int> msg_sizes = {1024, 10240, 102400, 1048576};
 
     if (rank == 0) {
-        std::cout << "Comp_Delay (us),Msg_Size (bytes),Exec_Time (s)\n";
+        std::cout << "Comp_Delay (us),Msg_Size (bytes),Exec_Time (s),Comm_Time (s),Overlap_Ratio\n";
     }
 
     for (int delay_us : comp_delays) {
         for (int msg_size : msg_sizes) {
-            auto start = std::chrono::high_resolution_clock::now();
-
+            BufferLease buf_a, buf_b;
             if (rank == 0) {
-                send_data(msg_size, rank, size);
-                for (int i = 1; i < size; ++i) {
-                    receive_data(msg_size, rank);
-                }
+                buf_a = buffer_pool().acquire(msg_size);
+                std::memset(buf_a.data(), rank, msg_size);
+                buf_b = buffer_pool().acquire(static_cast<size_t>(size - 1) * msg_size, true);
             } else {
-                receive_data(msg_size, rank);
-                do_computations(delay_us / size);
-                send_back_data(msg_size, rank);
+                int max_chunk = (msg_size + num_chunks - 1) / num_chunks;
+                buf_a = buffer_pool().acquire(2 * max_chunk, true);
+                buf_b = buffer_pool().acquire(2 * max_chunk, true);
+            }
+
+            // Communication alone: the same pipeline with nothing to hide behind.
+            PipelineStats comm_only = run_pipeline(msg_size, 0, rank, size, buf_a.data(), buf_b.data());
+            PipelineStats overlapped = run_pipeline(msg_size, delay_us / size, rank, size, buf_a.data(), buf_b.data());
+
+            double hidden = 0.0;
+            if (rank != 0 && comm_only.exec_time > 0.0) {
+                hidden = 1.0 - overlapped.wait_time / comm_only.exec_time;
+                hidden = std::max(0.0, std::min(1.0, hidden));
             }
 
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> exec_time = end - start;
+            double hidden_sum = 0.0;
+            double comm_max = 0.0;
+            MPI_Reduce(&hidden, &hidden_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+            MPI_Reduce(&comm_only.exec_time, &comm_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 
             if (rank == 0) {
+                double overlap_ratio = size > 1 ? hidden_sum / (size - 1) : 0.0;
                 std::cout << delay_us << ","
                           << msg_size << ","
-                          << exec_time.count() << "\n";
+                          << overlapped.exec_time << ","
+                          << comm_max << ","
+                          << overlap_ratio << "\n";
             }
         }
     }
 
+    buffer_pool().clear();
     MPI_Finalize();
     return 0;
 }
@@ -1,211 +1,1217 @@
 #include <mpi.h>
 #include <iostream>
 #include <vector>
+#include <string>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <chrono>
 
 using namespace std;
 using namespace std::chrono;
 
+// All collectives below are rooted at rank 0 and use binomial trees, so they
+// work for any number of processes. Scatter/gather/allgather move size / n_procs
+// elements per rank, like the MPI_Scatter/MPI_Gather calls they are compared with.
+
+int largest_pow2(int n) {
+    int p = 1;
+    while (p * 2 <= n) {
+        p *= 2;
+    }
+    return p;
+}
+
 void mpi_broadcast(int* data, int size, int rank, int n_procs) {
-    int partner;
-    for (int step = 1; step < n_procs; step *= 2) {
-        partner = rank ^ step;
-        if (partner < n_procs) {
-            if (rank < partner) {
-                MPI_Send(data, size, MPI_INT, partner, 0, MPI_COMM_WORLD);
-            } else {
-                MPI_Recv(data, size, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            }
+    int mask = 1;
+    while (mask < n_procs) {
+        if (rank & mask) {
+            MPI_Recv(data, size, MPI_INT, rank - mask, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            break;
         }
+        mask <<= 1;
+    }
+
+    mask >>= 1;
+    while (mask > 0) {
+        if (rank + mask < n_procs) {
+            MPI_Send(data, size, MPI_INT, rank + mask, 0, MPI_COMM_WORLD);
+        }
+        mask >>= 1;
     }
 }
 
+// Rank r owns the chunks of ranks [r, r + lowest set bit of r) in the tree.
 void mpi_scatter(int* data, int* local_data, int size, int rank, int n_procs) {
     int chunk_size = size / n_procs;
-    int partner;
-    for (int step = 1; step < n_procs; step *= 2) {
-        partner = rank ^ step;
-        if (partner < n_procs) {
-            if (rank < partner) {
-                MPI_Send(data + rank * chunk_size, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD);
-            } else {
-                MPI_Recv(local_data, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            }
+    vector<int> subtree;
+    int* tmp = data;
+
+    int mask = 1;
+    while (mask < n_procs) {
+        if (rank & mask) {
+            int chunks = min(mask, n_procs - rank);
+            subtree.resize(static_cast<size_t>(chunks) * chunk_size);
+            tmp = subtree.data();
+            MPI_Recv(tmp, chunks * chunk_size, MPI_INT, rank - mask, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            break;
         }
+        mask <<= 1;
     }
+
+    mask >>= 1;
+    while (mask > 0) {
+        if (rank + mask < n_procs) {
+            int chunks = min(mask, n_procs - rank - mask);
+            MPI_Send(tmp + mask * chunk_size, chunks * chunk_size, MPI_INT, rank + mask, 0, MPI_COMM_WORLD);
+        }
+        mask >>= 1;
+    }
+
+    std::copy(tmp, tmp + chunk_size, local_data);
 }
 
 void mpi_gather(int* local_data, int* data, int size, int rank, int n_procs) {
     int chunk_size = size / n_procs;
-    int partner;
-    for (int step = 1; step < n_procs; step *= 2) {
-        partner = rank ^ step;
-        if (partner < n_procs) {
-            if (rank < partner) {
-                MPI_Recv(data + partner * chunk_size, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            } else {
-                MPI_Send(local_data, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD);
-            }
-        }
-    }
-}
-
-void mpi_reduce(int* data, int* result, int size, int rank, int n_procs) {
-    int partner;
-    for (int step = 1; step < n_procs; step *= 2) {
-        partner = rank ^ step;
-        if (partner < n_procs) {
-            if (rank < partner) {
-                MPI_Send(data, size, MPI_INT, partner, 0, MPI_COMM_WORLD);
-                break;
-            } else {
-                MPI_Recv(result, size, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                for (int i = 0; i < size; i++) {
-                    result[i] = std::min(result[i], data[i]);
-                }
-                break;
-            }
+    vector<int> subtree;
+    int* tmp = data;
+    if (rank != 0) {
+        int low_bit = rank & -rank;
+        subtree.resize(static_cast<size_t>(min(low_bit, n_procs - rank)) * chunk_size);
+        tmp = subtree.data();
+    }
+    std::copy(local_data, local_data + chunk_size, tmp);
+
+    int mask = 1;
+    while (mask < n_procs) {
+        if (rank & mask) {
+            int chunks = min(mask, n_procs - rank);
+            MPI_Send(tmp, chunks * chunk_size, MPI_INT, rank - mask, 0, MPI_COMM_WORLD);
+            break;
+        }
+        if (rank + mask < n_procs) {
+            int chunks = min(mask, n_procs - rank - mask);
+            MPI_Recv(tmp + mask * chunk_size, chunks * chunk_size, MPI_INT, rank + mask, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         }
+        mask <<= 1;
     }
 }
 
+void mpi_reduce(int* data, int* result, int size, int rank, int n_procs, MPI_Op op) {
+    vector<int> acc(data, data + size);
+    vector<int> incoming(size);
+
+    int mask = 1;
+    while (mask < n_procs) {
+        if (rank & mask) {
+            MPI_Send(acc.data(), size, MPI_INT, rank - mask, 0, MPI_COMM_WORLD);
+            break;
+        }
+        if (rank + mask < n_procs) {
+            MPI_Recv(incoming.data(), size, MPI_INT, rank + mask, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(incoming.data(), acc.data(), size, MPI_INT, op);
+        }
+        mask <<= 1;
+    }
+
+    if (rank == 0) {
+        std::copy(acc.begin(), acc.end(), result);
+    }
+}
+
+// Recursive doubling over the largest power of two p2 <= n_procs. Rank r >= p2
+// first hands its chunk to r - p2, which then carries two blocks: its own in
+// [0, p2) and the extra one in [p2, n_procs). Both ranges stay contiguous for
+// every group of partners, so each step is two Sendrecv calls.
 void mpi_allgather(int* local_data, int* data, int size, int rank, int n_procs) {
     int chunk_size = size / n_procs;
-    int partner;
-    for (int step = 1; step < n_procs; step *= 2) {
-        partner = rank ^ step;
-        if (partner < n_procs) {
-            if (rank < partner) {
-                MPI_Recv(data + partner * chunk_size, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            } else {
-                MPI_Send(local_data, chunk_size, MPI_INT, partner, 0, MPI_COMM_WORLD);
+    int p2 = largest_pow2(n_procs);
+    int extra = n_procs - p2;
+
+    std::copy(local_data, local_data + chunk_size, data + rank * chunk_size);
+
+    if (rank >= p2) {
+        MPI_Send(local_data, chunk_size, MPI_INT, rank - p2, 0, MPI_COMM_WORLD);
+    } else {
+        if (rank < extra) {
+            MPI_Recv(data + (rank + p2) * chunk_size, chunk_size, MPI_INT, rank + p2, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+
+        for (int mask = 1; mask < p2; mask <<= 1) {
+            int partner = rank ^ mask;
+            int my_base = rank & ~(mask - 1);
+            int peer_base = partner & ~(mask - 1);
+
+            MPI_Sendrecv(data + my_base * chunk_size, mask * chunk_size, MPI_INT, partner, 0,
+                         data + peer_base * chunk_size, mask * chunk_size, MPI_INT, partner, 0,
+                         MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+            int my_extra = max(0, min(mask, extra - my_base));
+            int peer_extra = max(0, min(mask, extra - peer_base));
+            if (my_extra > 0 || peer_extra > 0) {
+                MPI_Sendrecv(data + (p2 + my_base) * chunk_size, my_extra * chunk_size, MPI_INT, partner, 1,
+                             data + (p2 + peer_base) * chunk_size, peer_extra * chunk_size, MPI_INT, partner, 1,
+                             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
             }
         }
     }
+
+    if (rank < extra) {
+        MPI_Send(data, n_procs * chunk_size, MPI_INT, rank + p2, 2, MPI_COMM_WORLD);
+    } else if (rank >= p2) {
+        MPI_Recv(data, n_procs * chunk_size, MPI_INT, rank - p2, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
 }
 
-int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
+// Same folding as mpi_allgather: ranks beyond the power of two contribute to a
+// partner, sit out the doubling, and get the result back at the end.
+void mpi_allreduce(const void* data, void* result, int size, MPI_Datatype type, MPI_Op op, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    int p2 = largest_pow2(n_procs);
+    int extra = n_procs - p2;
+    vector<char> incoming(static_cast<size_t>(size) * extent);
+    std::memcpy(result, data, static_cast<size_t>(size) * extent);
 
-    int rank, n_procs;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &n_procs);
+    if (rank >= p2) {
+        MPI_Send(result, size, type, rank - p2, 0, MPI_COMM_WORLD);
+    } else {
+        if (rank < extra) {
+            MPI_Recv(incoming.data(), size, type, rank + p2, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(incoming.data(), result, size, type, op);
+        }
+
+        for (int mask = 1; mask < p2; mask <<= 1) {
+            int partner = rank ^ mask;
+            MPI_Sendrecv(result, size, type, partner, 0,
+                         incoming.data(), size, type, partner, 0,
+                         MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Reduce_local(incoming.data(), result, size, type, op);
+        }
+    }
+
+    if (rank < extra) {
+        MPI_Send(result, size, type, rank + p2, 1, MPI_COMM_WORLD);
+    } else if (rank >= p2) {
+        MPI_Recv(result, size, type, rank - p2, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+// Pipelined broadcasts for large buffers. seg_size is in elements: a rank
+// forwards segment k to its children as soon as it has arrived, so the tree
+// depth is paid once per broadcast instead of once per full message.
+
+int binomial_parent(int rank) {
+    return rank - (rank & -rank);
+}
+
+vector<int> binomial_children(int rank, int n_procs) {
+    int limit = rank == 0 ? n_procs : (rank & -rank);
+    int mask = 1;
+    while (mask < limit) {
+        mask <<= 1;
+    }
 
-    int vec_size = 10000;
+    vector<int> children;
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (mask < limit && rank + mask < n_procs) {
+            children.push_back(rank + mask);
+        }
+    }
+    return children;
+}
+
+void pipelined_tree_bcast(int* data, int size, int seg_size, int parent, const vector<int>& children) {
+    vector<MPI_Request> reqs;
+    reqs.reserve(children.size() * ((size + seg_size - 1) / seg_size));
+
+    for (int offset = 0; offset < size; offset += seg_size) {
+        int count = min(seg_size, size - offset);
+        if (parent >= 0) {
+            MPI_Recv(data + offset, count, MPI_INT, parent, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        for (int child : children) {
+            reqs.emplace_back();
+            MPI_Isend(data + offset, count, MPI_INT, child, 0, MPI_COMM_WORLD, &reqs.back());
+        }
+    }
+    MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+}
+
+void mpi_broadcast_segmented(int* data, int size, int seg_size, int rank, int n_procs) {
+    int parent = rank == 0 ? -1 : binomial_parent(rank);
+    pipelined_tree_bcast(data, size, seg_size, parent, binomial_children(rank, n_procs));
+}
+
+void mpi_broadcast_chain(int* data, int size, int seg_size, int rank, int n_procs) {
+    int parent = rank == 0 ? -1 : rank - 1;
+    vector<int> children;
+    if (rank + 1 < n_procs) {
+        children.push_back(rank + 1);
+    }
+    pipelined_tree_bcast(data, size, seg_size, parent, children);
+}
+
+int block_start(int block, int size, int n_procs) {
+    return static_cast<int>(static_cast<long long>(block) * size / n_procs);
+}
+
+void sendrecv_segmented(int* send, int send_count, int dest, int* recv, int recv_count, int source, int seg_size) {
+    vector<MPI_Request> reqs;
+    for (int offset = 0; offset < recv_count; offset += seg_size) {
+        reqs.emplace_back();
+        MPI_Irecv(recv + offset, min(seg_size, recv_count - offset), MPI_INT, source, 0, MPI_COMM_WORLD, &reqs.back());
+    }
+    for (int offset = 0; offset < send_count; offset += seg_size) {
+        reqs.emplace_back();
+        MPI_Isend(send + offset, min(seg_size, send_count - offset), MPI_INT, dest, 0, MPI_COMM_WORLD, &reqs.back());
+    }
+    MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+}
+
+// Van de Geijn: binomial scatter of n_procs blocks, then a ring allgather in
+// which every rank passes one block to its right neighbour per step. Ring
+// messages are cut into seg_size pieces.
+void mpi_broadcast_scatter_allgather(int* data, int size, int seg_size, int rank, int n_procs) {
+    int mask = 1;
+    while (mask < n_procs) {
+        if (rank & mask) {
+            int first = block_start(rank, size, n_procs);
+            int last = block_start(min(rank + mask, n_procs), size, n_procs);
+            MPI_Recv(data + first, last - first, MPI_INT, rank - mask, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            break;
+        }
+        mask <<= 1;
+    }
+
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (rank + mask < n_procs) {
+            int first = block_start(rank + mask, size, n_procs);
+            int last = block_start(min(rank + 2 * mask, n_procs), size, n_procs);
+            MPI_Send(data + first, last - first, MPI_INT, rank + mask, 0, MPI_COMM_WORLD);
+        }
+    }
+
+    int left = (rank - 1 + n_procs) % n_procs;
+    int right = (rank + 1) % n_procs;
+    for (int step = 0; step < n_procs - 1; step++) {
+        int send_block = (rank - step + n_procs) % n_procs;
+        int recv_block = (rank - step - 1 + n_procs) % n_procs;
+        int send_first = block_start(send_block, size, n_procs);
+        int recv_first = block_start(recv_block, size, n_procs);
+        sendrecv_segmented(data + send_first, block_start(send_block + 1, size, n_procs) - send_first, right,
+                           data + recv_first, block_start(recv_block + 1, size, n_procs) - recv_first, left,
+                           seg_size);
+    }
+}
+
+// Bandwidth-optimal reductions for large vectors. They work on any datatype
+// and any commutative op through MPI_Reduce_local; block b of a count-element
+// vector split into n parts is [block_start(b), block_start(b + 1)).
+
+char* elem_ptr(void* base, long long index, MPI_Aint extent) {
+    return static_cast<char*>(base) + index * extent;
+}
+
+// Ring reduce-scatter, in place: after n_procs - 1 steps block `rank` of data
+// holds the reduction of that block over all ranks.
+void mpi_reduce_scatter_ring(void* data, int count, MPI_Datatype type, MPI_Op op, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    int left = (rank - 1 + n_procs) % n_procs;
+    int right = (rank + 1) % n_procs;
+    vector<char> incoming(static_cast<size_t>(count / n_procs + 1) * extent);
+
+    for (int step = 0; step < n_procs - 1; step++) {
+        int send_block = ((rank - step - 1) % n_procs + n_procs) % n_procs;
+        int recv_block = ((rank - step - 2) % n_procs + n_procs) % n_procs;
+        int send_first = block_start(send_block, count, n_procs);
+        int recv_first = block_start(recv_block, count, n_procs);
+        int send_count = block_start(send_block + 1, count, n_procs) - send_first;
+        int recv_count = block_start(recv_block + 1, count, n_procs) - recv_first;
+
+        MPI_Sendrecv(elem_ptr(data, send_first, extent), send_count, type, right, 0,
+                     incoming.data(), recv_count, type, left, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(incoming.data(), elem_ptr(data, recv_first, extent), recv_count, type, op);
+    }
+}
+
+// Ring allgather, in place: every rank starts with block `rank` of data.
+void mpi_allgather_ring(void* data, int count, MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    int left = (rank - 1 + n_procs) % n_procs;
+    int right = (rank + 1) % n_procs;
+
+    for (int step = 0; step < n_procs - 1; step++) {
+        int send_block = (rank - step + n_procs) % n_procs;
+        int recv_block = (rank - step - 1 + n_procs) % n_procs;
+        int send_first = block_start(send_block, count, n_procs);
+        int recv_first = block_start(recv_block, count, n_procs);
+
+        MPI_Sendrecv(elem_ptr(data, send_first, extent), block_start(send_block + 1, count, n_procs) - send_first, type, right, 0,
+                     elem_ptr(data, recv_first, extent), block_start(recv_block + 1, count, n_procs) - recv_first, type, left, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+void mpi_allreduce_ring(const void* data, void* result, int count, MPI_Datatype type, MPI_Op op, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    std::memcpy(result, data, static_cast<size_t>(count) * extent);
+    mpi_reduce_scatter_ring(result, count, type, op, rank, n_procs);
+    mpi_allgather_ring(result, count, type, rank, n_procs);
+}
+
+// Rabenseifner: ranks beyond the largest power of two p2 fold into a partner,
+// then recursive halving leaves block `rank` (of p2 blocks) fully reduced on
+// each of the p2 ranks, recursive doubling gathers the blocks back, and the
+// folded ranks receive the result.
+void mpi_allreduce_rabenseifner(const void* data, void* result, int count, MPI_Datatype type, MPI_Op op, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    int p2 = largest_pow2(n_procs);
+    int extra = n_procs - p2;
+    std::memcpy(result, data, static_cast<size_t>(count) * extent);
+
+    if (rank >= p2) {
+        MPI_Send(result, count, type, rank - p2, 0, MPI_COMM_WORLD);
+        MPI_Recv(result, count, type, rank - p2, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        return;
+    }
+
+    vector<char> incoming(static_cast<size_t>(count / 2 + p2) * extent);
+    if (rank < extra) {
+        incoming.resize(static_cast<size_t>(count) * extent);
+        MPI_Recv(incoming.data(), count, type, rank + p2, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(incoming.data(), result, count, type, op);
+    }
+
+    int lo = 0;
+    int hi = p2;
+    for (int mask = p2 / 2; mask > 0; mask >>= 1) {
+        int partner = rank ^ mask;
+        int mid = lo + mask;
+        int keep_lo = (rank & mask) ? mid : lo;
+        int keep_hi = (rank & mask) ? hi : mid;
+        int send_lo = (rank & mask) ? lo : mid;
+        int send_hi = (rank & mask) ? mid : hi;
+
+        int keep_first = block_start(keep_lo, count, p2);
+        int keep_count = block_start(keep_hi, count, p2) - keep_first;
+        int send_first = block_start(send_lo, count, p2);
+        int send_count = block_start(send_hi, count, p2) - send_first;
+
+        MPI_Sendrecv(elem_ptr(result, send_first, extent), send_count, type, partner, 0,
+                     incoming.data(), keep_count, type, partner, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Reduce_local(incoming.data(), elem_ptr(result, keep_first, extent), keep_count, type, op);
+        lo = keep_lo;
+        hi = keep_hi;
+    }
+
+    for (int mask = 1; mask < p2; mask <<= 1) {
+        int partner = rank ^ mask;
+        int my_base = rank & ~(mask - 1);
+        int peer_base = partner & ~(mask - 1);
+        int my_first = block_start(my_base, count, p2);
+        int peer_first = block_start(peer_base, count, p2);
+
+        MPI_Sendrecv(elem_ptr(result, my_first, extent), block_start(my_base + mask, count, p2) - my_first, type, partner, 0,
+                     elem_ptr(result, peer_first, extent), block_start(peer_base + mask, count, p2) - peer_first, type, partner, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+
+    if (rank < extra) {
+        MPI_Send(result, count, type, rank + p2, 1, MPI_COMM_WORLD);
+    }
+}
+
+// All-to-all personalized exchange: block d of sendbuf (count elements) goes
+// to rank d and arrives as block `rank` of rank d's recvbuf.
+
+void mpi_alltoall_pairwise(const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    void* send = const_cast<void*>(sendbuf);
+    std::memcpy(elem_ptr(recvbuf, static_cast<long long>(rank) * count, extent),
+                elem_ptr(send, static_cast<long long>(rank) * count, extent), static_cast<size_t>(count) * extent);
+
+    for (int step = 1; step < n_procs; step++) {
+        int dest = (rank + step) % n_procs;
+        int source = (rank - step + n_procs) % n_procs;
+        MPI_Sendrecv(elem_ptr(send, static_cast<long long>(dest) * count, extent), count, type, dest, 0,
+                     elem_ptr(recvbuf, static_cast<long long>(source) * count, extent), count, type, source, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+// Every send and receive is posted at once, each rank starting with a
+// different peer so that no single rank is hit by everybody first.
+void mpi_alltoall_spread_out(const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    void* send = const_cast<void*>(sendbuf);
+    vector<MPI_Request> reqs(2 * n_procs);
+
+    for (int i = 0; i < n_procs; i++) {
+        int source = (rank - i + n_procs) % n_procs;
+        MPI_Irecv(elem_ptr(recvbuf, static_cast<long long>(source) * count, extent), count, type, source, 0, MPI_COMM_WORLD, &reqs[i]);
+    }
+    for (int i = 0; i < n_procs; i++) {
+        int dest = (rank + i) % n_procs;
+        MPI_Isend(elem_ptr(send, static_cast<long long>(dest) * count, extent), count, type, dest, 0, MPI_COMM_WORLD, &reqs[n_procs + i]);
+    }
+    MPI_Waitall(2 * n_procs, reqs.data(), MPI_STATUSES_IGNORE);
+}
+
+// Bruck: rotate blocks so that slot i holds the block for rank + i, then in
+// ceil(log2 P) steps send every slot with bit k set to rank + k, and finally
+// undo the rotation. Each block travels up to log P times, but there are
+// only log P messages, which wins for small blocks.
+void mpi_alltoall_bruck(const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    size_t block_bytes = static_cast<size_t>(count) * extent;
+    const char* send = static_cast<const char*>(sendbuf);
+    char* recv = static_cast<char*>(recvbuf);
+    vector<char> tmp(block_bytes * n_procs);
+    vector<char> packed(block_bytes * ((n_procs + 1) / 2));
+    vector<char> incoming(packed.size());
+
+    for (int i = 0; i < n_procs; i++) {
+        std::memcpy(tmp.data() + i * block_bytes, send + ((rank + i) % n_procs) * block_bytes, block_bytes);
+    }
+
+    for (int k = 1; k < n_procs; k <<= 1) {
+        int n_blocks = 0;
+        for (int i = 0; i < n_procs; i++) {
+            if (i & k) {
+                std::memcpy(packed.data() + n_blocks * block_bytes, tmp.data() + i * block_bytes, block_bytes);
+                n_blocks++;
+            }
+        }
+
+        int dest = (rank + k) % n_procs;
+        int source = (rank - k + n_procs) % n_procs;
+        MPI_Sendrecv(packed.data(), static_cast<int>(n_blocks * block_bytes), MPI_BYTE, dest, 0,
+                     incoming.data(), static_cast<int>(n_blocks * block_bytes), MPI_BYTE, source, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        n_blocks = 0;
+        for (int i = 0; i < n_procs; i++) {
+            if (i & k) {
+                std::memcpy(tmp.data() + i * block_bytes, incoming.data() + n_blocks * block_bytes, block_bytes);
+                n_blocks++;
+            }
+        }
+    }
+
+    for (int i = 0; i < n_procs; i++) {
+        std::memcpy(recv + ((rank - i + n_procs) % n_procs) * block_bytes, tmp.data() + i * block_bytes, block_bytes);
+    }
+}
+
+// Alltoallv counterparts take per-peer counts and displacements in elements,
+// with the same meaning as in MPI_Alltoallv.
+void mpi_alltoallv_pairwise(const void* sendbuf, const int* send_counts, const int* send_displs,
+                            void* recvbuf, const int* recv_counts, const int* recv_displs,
+                            MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    void* send = const_cast<void*>(sendbuf);
+    std::memcpy(elem_ptr(recvbuf, recv_displs[rank], extent), elem_ptr(send, send_displs[rank], extent),
+                static_cast<size_t>(send_counts[rank]) * extent);
+
+    for (int step = 1; step < n_procs; step++) {
+        int dest = (rank + step) % n_procs;
+        int source = (rank - step + n_procs) % n_procs;
+        MPI_Sendrecv(elem_ptr(send, send_displs[dest], extent), send_counts[dest], type, dest, 0,
+                     elem_ptr(recvbuf, recv_displs[source], extent), recv_counts[source], type, source, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+}
+
+void mpi_alltoallv_spread_out(const void* sendbuf, const int* send_counts, const int* send_displs,
+                              void* recvbuf, const int* recv_counts, const int* recv_displs,
+                              MPI_Datatype type, int rank, int n_procs) {
+    MPI_Aint lb, extent;
+    MPI_Type_get_extent(type, &lb, &extent);
+    void* send = const_cast<void*>(sendbuf);
+    vector<MPI_Request> reqs(2 * n_procs);
+
+    for (int i = 0; i < n_procs; i++) {
+        int source = (rank - i + n_procs) % n_procs;
+        MPI_Irecv(elem_ptr(recvbuf, recv_displs[source], extent), recv_counts[source], type, source, 0, MPI_COMM_WORLD, &reqs[i]);
+    }
+    for (int i = 0; i < n_procs; i++) {
+        int dest = (rank + i) % n_procs;
+        MPI_Isend(elem_ptr(send, send_displs[dest], extent), send_counts[dest], type, dest, 0, MPI_COMM_WORLD, &reqs[n_procs + i]);
+    }
+    MPI_Waitall(2 * n_procs, reqs.data(), MPI_STATUSES_IGNORE);
+}
+
+enum Algo {
+    ALGO_MPI,
+    ALGO_BINOMIAL,
+    ALGO_SEGMENTED,
+    ALGO_CHAIN,
+    ALGO_SCATTER_ALLGATHER,
+    ALGO_RECURSIVE_DOUBLING,
+    ALGO_RABENSEIFNER,
+    ALGO_RING,
+    ALGO_PAIRWISE,
+    ALGO_BRUCK,
+    ALGO_SPREAD_OUT,
+    ALGO_AUTO
+};
+
+const char* algo_name(Algo algo) {
+    switch (algo) {
+    case ALGO_MPI: return "MPI";
+    case ALGO_BINOMIAL: return "binomial";
+    case ALGO_SEGMENTED: return "segmented binomial";
+    case ALGO_CHAIN: return "chain";
+    case ALGO_SCATTER_ALLGATHER: return "scatter+allgather";
+    case ALGO_RECURSIVE_DOUBLING: return "recursive doubling";
+    case ALGO_RABENSEIFNER: return "rabenseifner";
+    case ALGO_RING: return "ring";
+    case ALGO_PAIRWISE: return "pairwise";
+    case ALGO_BRUCK: return "bruck";
+    case ALGO_SPREAD_OUT: return "spread-out";
+    case ALGO_AUTO: return "auto";
+    }
+    return "unknown";
+}
+
+// Decision table written by './9 tune' and read by ALGO_AUTO. One rule per
+// line: collective,comm_size,max_bytes,algorithm,segment_bytes. A message of
+// b bytes uses the first rule (by max_bytes) of the nearest comm_size with
+// b <= max_bytes, or the last one if it is larger than all of them.
+struct TuningRule {
+    string collective;
+    int comm_size;
+    long long max_bytes;
+    Algo algo;
+    int seg_bytes;
+};
+
+vector<TuningRule> tuning_table;
+
+bool algo_from_name(const string& name, Algo& algo) {
+    for (int a = ALGO_MPI; a < ALGO_AUTO; a++) {
+        if (name == algo_name(static_cast<Algo>(a))) {
+            algo = static_cast<Algo>(a);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Rank 0 reads the file and broadcasts it, so every rank picks the same
+// algorithm even without a shared file system.
+void load_tuning_table(const string& path, int rank) {
+    string text;
+    if (rank == 0) {
+        std::ifstream in(path);
+        std::stringstream buf;
+        buf << in.rdbuf();
+        text = buf.str();
+    }
+    int len = static_cast<int>(text.size());
+    MPI_Bcast(&len, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    text.resize(len);
+    MPI_Bcast(&text[0], len, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    tuning_table.clear();
+    std::istringstream lines(text);
+    string line;
+    while (std::getline(lines, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        TuningRule rule;
+        string comm_size, max_bytes, algo, seg_bytes;
+        std::getline(fields, rule.collective, ',');
+        std::getline(fields, comm_size, ',');
+        std::getline(fields, max_bytes, ',');
+        std::getline(fields, algo, ',');
+        std::getline(fields, seg_bytes, ',');
+        if (!algo_from_name(algo, rule.algo)) {
+            continue;
+        }
+        rule.comm_size = atoi(comm_size.c_str());
+        rule.max_bytes = atoll(max_bytes.c_str());
+        rule.seg_bytes = atoi(seg_bytes.c_str());
+        tuning_table.push_back(rule);
+    }
+}
+
+void save_tuning_table(const string& path) {
+    std::ofstream out(path);
+    out << "# collective,comm_size,max_bytes,algorithm,segment_bytes\n";
+    for (const TuningRule& rule : tuning_table) {
+        out << rule.collective << "," << rule.comm_size << "," << rule.max_bytes << ","
+            << algo_name(rule.algo) << "," << rule.seg_bytes << "\n";
+    }
+}
+
+// Falls back to the MPI built-in when the table has nothing for collective.
+TuningRule tuned_choice(const string& collective, long long bytes, int n_procs) {
+    TuningRule choice = {collective, n_procs, bytes, ALGO_MPI, 0};
+    int best_distance = -1;
+    for (const TuningRule& rule : tuning_table) {
+        if (rule.collective == collective) {
+            int distance = abs(rule.comm_size - n_procs);
+            if (best_distance < 0 || distance < best_distance) {
+                best_distance = distance;
+            }
+        }
+    }
+
+    long long best_max = -1;
+    for (const TuningRule& rule : tuning_table) {
+        if (rule.collective != collective || abs(rule.comm_size - n_procs) != best_distance) {
+            continue;
+        }
+        bool fits = bytes <= rule.max_bytes;
+        bool choice_fits = bytes <= best_max;
+        if (best_max < 0 || (fits && (!choice_fits || rule.max_bytes < best_max))
+            || (!fits && !choice_fits && rule.max_bytes > best_max)) {
+            choice = rule;
+            best_max = rule.max_bytes;
+        }
+    }
+    return choice;
+}
+
+void bench_bcast(int* data, int size, int seg_size, int rank, int n_procs, Algo algo) {
+    if (algo == ALGO_AUTO) {
+        TuningRule rule = tuned_choice("bcast", static_cast<long long>(size) * sizeof(int), n_procs);
+        algo = rule.algo;
+        seg_size = max(1, rule.seg_bytes / static_cast<int>(sizeof(int)));
+    }
+
+    switch (algo) {
+    case ALGO_MPI:
+        MPI_Bcast(data, size, MPI_INT, 0, MPI_COMM_WORLD);
+        break;
+    case ALGO_BINOMIAL:
+        mpi_broadcast(data, size, rank, n_procs);
+        break;
+    case ALGO_SEGMENTED:
+        mpi_broadcast_segmented(data, size, seg_size, rank, n_procs);
+        break;
+    case ALGO_CHAIN:
+        mpi_broadcast_chain(data, size, seg_size, rank, n_procs);
+        break;
+    case ALGO_SCATTER_ALLGATHER:
+        mpi_broadcast_scatter_allgather(data, size, seg_size, rank, n_procs);
+        break;
+    default:
+        break;
+    }
+}
+
+void bench_allreduce(const void* data, void* result, int count, MPI_Datatype type, MPI_Op op, int rank, int n_procs, Algo algo) {
+    if (algo == ALGO_AUTO) {
+        int type_size;
+        MPI_Type_size(type, &type_size);
+        algo = tuned_choice("allreduce", static_cast<long long>(count) * type_size, n_procs).algo;
+    }
+
+    switch (algo) {
+    case ALGO_MPI:
+        MPI_Allreduce(data, result, count, type, op, MPI_COMM_WORLD);
+        break;
+    case ALGO_RECURSIVE_DOUBLING:
+        mpi_allreduce(data, result, count, type, op, rank, n_procs);
+        break;
+    case ALGO_RABENSEIFNER:
+        mpi_allreduce_rabenseifner(data, result, count, type, op, rank, n_procs);
+        break;
+    case ALGO_RING:
+        mpi_allreduce_ring(data, result, count, type, op, rank, n_procs);
+        break;
+    default:
+        break;
+    }
+}
+
+void bench_alltoall(const void* sendbuf, void* recvbuf, int count, MPI_Datatype type, int rank, int n_procs, Algo algo) {
+    switch (algo) {
+    case ALGO_MPI:
+        MPI_Alltoall(sendbuf, count, type, recvbuf, count, type, MPI_COMM_WORLD);
+        break;
+    case ALGO_PAIRWISE:
+        mpi_alltoall_pairwise(sendbuf, recvbuf, count, type, rank, n_procs);
+        break;
+    case ALGO_BRUCK:
+        mpi_alltoall_bruck(sendbuf, recvbuf, count, type, rank, n_procs);
+        break;
+    case ALGO_SPREAD_OUT:
+        mpi_alltoall_spread_out(sendbuf, recvbuf, count, type, rank, n_procs);
+        break;
+    default:
+        break;
+    }
+}
+
+int runs_for_bytes(long long bytes) {
+    if (bytes <= (1 << 20)) {
+        return 20;
+    }
+    return bytes <= (16 << 20) ? 5 : 2;
+}
+
+// Runs op num_runs times after a barrier and returns the average time per
+// call on the slowest rank, so rooted collectives are not judged by a root
+// that finishes early. Every rank gets the same value.
+template <typename Op>
+double time_op(Op op, int num_runs) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start_time = high_resolution_clock::now();
+    for (int i = 0; i < num_runs; i++) {
+        op();
+    }
+    auto end_time = high_resolution_clock::now();
+    duration<double> elapsed = end_time - start_time;
+    double local = elapsed.count() / num_runs;
+    double slowest = 0.0;
+    MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return slowest;
+}
+
+// Every rank passes whether its own part of the result matched; rank 0 learns
+// whether all of them did.
+bool all_ranks_agree(bool local_ok) {
+    int ok = local_ok ? 1 : 0;
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    return all_ok != 0;
+}
+
+void report(int rank, const string& operation, const string& type, double time, bool correct) {
+    if (rank == 0) {
+        std::cout << operation << "," << type << "," << time << "," << (correct ? "Yes" : "No") << std::endl;
+    }
+}
+
+void run_basic_suite(int vec_size, int rank, int n_procs, int num_runs) {
+    int chunk = vec_size / n_procs;
     std::vector<int> data(vec_size, 0);
-    std::vector<int> local_data(vec_size / n_procs, 0);
+    std::vector<int> local_data(chunk, 0);
+    std::vector<int> out(vec_size, 0);
+    std::vector<int> ref(vec_size, 0);
 
     if (rank == 0) {
         for (int i = 0; i < vec_size; i++) {
             data[i] = rand() % 100;
         }
     }
+    std::vector<int> root_data = data;
+    std::vector<int> own(vec_size);
+    for (int i = 0; i < vec_size; i++) {
+        own[i] = (rank * 31 + i * 7) % 1000;
+    }
+    std::vector<int> own_chunk(own.begin(), own.begin() + chunk);
 
     if (rank == 0) {
-        std::cout << "Operation,Time (seconds)" << std::endl;
+        std::cout << "Operation,Type,Time (seconds),Correct" << std::endl;
     }
 
+    // Broadcast
+    out = root_data;
+    ref = root_data;
+    mpi_broadcast(out.data(), vec_size, rank, n_procs);
+    MPI_Bcast(ref.data(), vec_size, MPI_INT, 0, MPI_COMM_WORLD);
+    bool ok = all_ranks_agree(out == ref);
+    double t_own = time_op([&] { mpi_broadcast(out.data(), vec_size, rank, n_procs); }, num_runs);
+    double t_mpi = time_op([&] { MPI_Bcast(ref.data(), vec_size, MPI_INT, 0, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "Broadcast", "binomial", t_own, ok);
+    report(rank, "Broadcast", "MPI", t_mpi, true);
+
+    // Scatter
+    std::vector<int> ref_chunk(chunk, 0);
+    mpi_scatter(root_data.data(), local_data.data(), vec_size, rank, n_procs);
+    MPI_Scatter(root_data.data(), chunk, MPI_INT, ref_chunk.data(), chunk, MPI_INT, 0, MPI_COMM_WORLD);
+    ok = all_ranks_agree(local_data == ref_chunk);
+    t_own = time_op([&] { mpi_scatter(root_data.data(), local_data.data(), vec_size, rank, n_procs); }, num_runs);
+    t_mpi = time_op([&] { MPI_Scatter(root_data.data(), chunk, MPI_INT, ref_chunk.data(), chunk, MPI_INT, 0, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "Scatter", "binomial", t_own, ok);
+    report(rank, "Scatter", "MPI", t_mpi, true);
+
+    // Gather
+    std::fill(out.begin(), out.end(), 0);
+    std::fill(ref.begin(), ref.end(), 0);
+    mpi_gather(own_chunk.data(), out.data(), vec_size, rank, n_procs);
+    MPI_Gather(own_chunk.data(), chunk, MPI_INT, ref.data(), chunk, MPI_INT, 0, MPI_COMM_WORLD);
+    ok = all_ranks_agree(rank != 0 || out == ref);
+    t_own = time_op([&] { mpi_gather(own_chunk.data(), out.data(), vec_size, rank, n_procs); }, num_runs);
+    t_mpi = time_op([&] { MPI_Gather(own_chunk.data(), chunk, MPI_INT, ref.data(), chunk, MPI_INT, 0, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "Gather", "binomial", t_own, ok);
+    report(rank, "Gather", "MPI", t_mpi, true);
+
+    // Reduce
+    mpi_reduce(own.data(), out.data(), vec_size, rank, n_procs, MPI_MIN);
+    MPI_Reduce(own.data(), ref.data(), vec_size, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+    ok = all_ranks_agree(rank != 0 || out == ref);
+    t_own = time_op([&] { mpi_reduce(own.data(), out.data(), vec_size, rank, n_procs, MPI_MIN); }, num_runs);
+    t_mpi = time_op([&] { MPI_Reduce(own.data(), ref.data(), vec_size, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "Reduce", "binomial", t_own, ok);
+    report(rank, "Reduce", "MPI", t_mpi, true);
+
+    // Allgather
+    std::fill(out.begin(), out.end(), 0);
+    std::fill(ref.begin(), ref.end(), 0);
+    mpi_allgather(own_chunk.data(), out.data(), vec_size, rank, n_procs);
+    MPI_Allgather(own_chunk.data(), chunk, MPI_INT, ref.data(), chunk, MPI_INT, MPI_COMM_WORLD);
+    ok = all_ranks_agree(std::equal(out.begin(), out.begin() + chunk * n_procs, ref.begin()));
+    t_own = time_op([&] { mpi_allgather(own_chunk.data(), out.data(), vec_size, rank, n_procs); }, num_runs);
+    t_mpi = time_op([&] { MPI_Allgather(own_chunk.data(), chunk, MPI_INT, ref.data(), chunk, MPI_INT, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "AllGather", "recursive doubling", t_own, ok);
+    report(rank, "AllGather", "MPI", t_mpi, true);
+
+    // Allreduce
+    mpi_allreduce(own.data(), out.data(), vec_size, MPI_INT, MPI_SUM, rank, n_procs);
+    MPI_Allreduce(own.data(), ref.data(), vec_size, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    ok = all_ranks_agree(out == ref);
+    t_own = time_op([&] { mpi_allreduce(own.data(), out.data(), vec_size, MPI_INT, MPI_SUM, rank, n_procs); }, num_runs);
+    t_mpi = time_op([&] { MPI_Allreduce(own.data(), ref.data(), vec_size, MPI_INT, MPI_SUM, MPI_COMM_WORLD); }, num_runs);
+    report(rank, "AllReduce", "recursive doubling", t_own, ok);
+    report(rank, "AllReduce", "MPI", t_mpi, true);
+}
+
+// Broadcast sweep from 4KB to max_bytes. The root fills a known pattern and
+// every rank checks it after the first call of each algorithm.
+void run_bcast_suite(long long max_bytes, int rank, int n_procs) {
+    const vector<Algo> algos = {ALGO_SEGMENTED, ALGO_CHAIN, ALGO_SCATTER_ALLGATHER};
+    const vector<int> seg_bytes = {8192, 65536, 524288};
+
     if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        mpi_broadcast(data.data(), vec_size, rank, n_procs);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Broadcast (pairwise)," << elapsed.count() << std::endl;
-    } else {
-        mpi_broadcast(data.data(), vec_size, rank, n_procs);
+        std::cout << "Size (bytes),Algorithm,Segment (bytes),Time (seconds),Bandwidth (MB/s),Correct" << std::endl;
     }
 
-    if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        mpi_scatter(data.data(), local_data.data(), vec_size, rank, n_procs);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Scatter (pairwise)," << elapsed.count() << std::endl;
-    } else {
-        mpi_scatter(data.data(), local_data.data(), vec_size, rank, n_procs);
+    for (long long bytes = 4096; bytes <= max_bytes; bytes *= 4) {
+        int count = static_cast<int>(bytes / sizeof(int));
+        int num_runs = runs_for_bytes(bytes);
+        vector<int> data(count);
+
+        auto run = [&](Algo algo, int seg) {
+            int seg_size = max(1, seg / static_cast<int>(sizeof(int)));
+            for (int i = 0; i < count; i++) {
+                data[i] = rank == 0 ? i % 1000003 : -1;
+            }
+            bench_bcast(data.data(), count, seg_size, rank, n_procs, algo);
+            bool local_ok = true;
+            for (int i = 0; i < count; i++) {
+                if (data[i] != i % 1000003) {
+                    local_ok = false;
+                    break;
+                }
+            }
+            bool ok = all_ranks_agree(local_ok);
+            double t = time_op([&] { bench_bcast(data.data(), count, seg_size, rank, n_procs, algo); }, num_runs);
+            if (rank == 0) {
+                std::cout << bytes << "," << algo_name(algo) << "," << seg << "," << t << ","
+                          << bytes / t / 1e6 << "," << (ok ? "Yes" : "No") << std::endl;
+            }
+        };
+
+        run(ALGO_MPI, 0);
+        run(ALGO_BINOMIAL, 0);
+        run(ALGO_AUTO, 0);
+        for (Algo algo : algos) {
+            for (int seg : seg_bytes) {
+                run(algo, seg);
+            }
+        }
     }
+}
 
-    if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        mpi_gather(local_data.data(), data.data(), vec_size, rank, n_procs);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Gather (pairwise)," << elapsed.count() << std::endl;
-    } else {
-        mpi_gather(local_data.data(), data.data(), vec_size, rank, n_procs);
+// Checks every allreduce algorithm against MPI_Allreduce for a few datatype/op
+// pairs on an odd-sized vector, so uneven blocks and folding are exercised.
+template <typename T>
+bool check_allreduce_type(MPI_Datatype type, MPI_Op op, int rank, int n_procs) {
+    const int count = 1001;
+    vector<T> input(count), out(count), ref(count);
+    for (int i = 0; i < count; i++) {
+        input[i] = static_cast<T>((rank * 37 + i * 11) % 101);
     }
+    MPI_Allreduce(input.data(), ref.data(), count, type, op, MPI_COMM_WORLD);
 
-    if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        mpi_reduce(data.data(), data.data(), vec_size, rank, n_procs);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Reduce (pairwise)," << elapsed.count() << std::endl;
-    } else {
-        mpi_reduce(data.data(), data.data(), vec_size, rank, n_procs);
+    bool ok = true;
+    for (Algo algo : {ALGO_RECURSIVE_DOUBLING, ALGO_RABENSEIFNER, ALGO_RING}) {
+        std::fill(out.begin(), out.end(), T());
+        bench_allreduce(input.data(), out.data(), count, type, op, rank, n_procs, algo);
+        ok = ok && out == ref;
     }
+    return all_ranks_agree(ok);
+}
 
+// Allreduce sweep from 1KB to max_bytes of floats (MPI_SUM). Inputs are small
+// integers, so every summation order gives the exact same result.
+void run_allreduce_suite(long long max_bytes, int rank, int n_procs) {
+    bool types_ok = check_allreduce_type<int>(MPI_INT, MPI_MIN, rank, n_procs)
+                    && check_allreduce_type<double>(MPI_DOUBLE, MPI_MAX, rank, n_procs)
+                    && check_allreduce_type<long long>(MPI_LONG_LONG, MPI_SUM, rank, n_procs)
+                    && check_allreduce_type<unsigned>(MPI_UNSIGNED, MPI_BXOR, rank, n_procs);
     if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        mpi_allgather(local_data.data(), data.data(), vec_size, rank, n_procs);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "AllGather (pairwise)," << elapsed.count() << std::endl;
-    } else {
-        mpi_allgather(local_data.data(), data.data(), vec_size, rank, n_procs);
+        std::cout << "Datatype/op check," << (types_ok ? "Yes" : "No") << std::endl;
+        std::cout << "Size (bytes),Operation,Algorithm,Time (seconds),Bandwidth (MB/s),Correct" << std::endl;
     }
 
-    if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        MPI_Bcast(data.data(), vec_size, MPI_INT, 0, MPI_COMM_WORLD);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Broadcast (MPI_Bcast)," << elapsed.count() << std::endl;
-    } else {
-        MPI_Bcast(data.data(), vec_size, MPI_INT, 0, MPI_COMM_WORLD);
+    const float base = static_cast<float>(n_procs) * (n_procs - 1) / 2;
+    for (long long bytes = 1024; bytes <= max_bytes; bytes *= 4) {
+        int count = static_cast<int>(bytes / sizeof(float));
+        int num_runs = runs_for_bytes(bytes);
+        vector<float> input(count), out(count);
+        for (int i = 0; i < count; i++) {
+            input[i] = static_cast<float>(rank + i % 7);
+        }
+        auto expected = [&](int i) { return base + static_cast<float>(n_procs) * (i % 7); };
+
+        auto print = [&](const char* operation, Algo algo, double t, bool ok) {
+            if (rank == 0) {
+                std::cout << bytes << "," << operation << "," << algo_name(algo) << "," << t << ","
+                          << bytes / t / 1e6 << "," << (ok ? "Yes" : "No") << std::endl;
+            }
+        };
+
+        for (Algo algo : {ALGO_MPI, ALGO_RECURSIVE_DOUBLING, ALGO_RABENSEIFNER, ALGO_RING, ALGO_AUTO}) {
+            std::fill(out.begin(), out.end(), 0.0f);
+            bench_allreduce(input.data(), out.data(), count, MPI_FLOAT, MPI_SUM, rank, n_procs, algo);
+            bool local_ok = true;
+            for (int i = 0; i < count && local_ok; i++) {
+                local_ok = out[i] == expected(i);
+            }
+            bool ok = all_ranks_agree(local_ok);
+            double t = time_op([&] { bench_allreduce(input.data(), out.data(), count, MPI_FLOAT, MPI_SUM, rank, n_procs, algo); }, num_runs);
+            print("Allreduce", algo, t, ok);
+        }
+
+        int my_first = block_start(rank, count, n_procs);
+        int my_count = block_start(rank + 1, count, n_procs) - my_first;
+        vector<int> recv_counts(n_procs);
+        for (int r = 0; r < n_procs; r++) {
+            recv_counts[r] = block_start(r + 1, count, n_procs) - block_start(r, count, n_procs);
+        }
+
+        auto check_block = [&](const float* block) {
+            bool local_ok = true;
+            for (int i = 0; i < my_count && local_ok; i++) {
+                local_ok = block[i] == expected(my_first + i);
+            }
+            return all_ranks_agree(local_ok);
+        };
+
+        MPI_Reduce_scatter(input.data(), out.data(), recv_counts.data(), MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+        bool ok = check_block(out.data());
+        double t = time_op([&] { MPI_Reduce_scatter(input.data(), out.data(), recv_counts.data(), MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD); }, num_runs);
+        print("ReduceScatter", ALGO_MPI, t, ok);
+
+        auto ring_rs = [&] {
+            std::copy(input.begin(), input.end(), out.begin());
+            mpi_reduce_scatter_ring(out.data(), count, MPI_FLOAT, MPI_SUM, rank, n_procs);
+        };
+        ring_rs();
+        ok = check_block(out.data() + my_first);
+        t = time_op(ring_rs, num_runs);
+        print("ReduceScatter", ALGO_RING, t, ok);
     }
+}
 
+// Alltoall sweep over block sizes from 8 bytes to max_bytes per peer, checked
+// against MPI_Alltoall. The Alltoallv part uses skewed counts: every rank
+// sends 1..4 units to each peer and 8 extra units to its right neighbour.
+void run_alltoall_suite(long long max_bytes, int rank, int n_procs) {
     if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        MPI_Scatter(data.data(), vec_size / n_procs, MPI_INT, local_data.data(), vec_size / n_procs, MPI_INT, 0, MPI_COMM_WORLD);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Scatter (MPI_Scatter)," << elapsed.count() << std::endl;
-    } else {
-        MPI_Scatter(data.data(), vec_size / n_procs, MPI_INT, local_data.data(), vec_size / n_procs, MPI_INT, 0, MPI_COMM_WORLD);
+        std::cout << "Block size (bytes),Operation,Algorithm,Time (seconds),Bandwidth (MB/s),Correct" << std::endl;
     }
 
-    if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        MPI_Gather(local_data.data(), vec_size / n_procs, MPI_INT, data.data(), vec_size / n_procs, MPI_INT, 0, MPI_COMM_WORLD);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Gather (MPI_Gather)," << elapsed.count() << std::endl;
-    } else {
-        MPI_Gather(local_data.data(), vec_size / n_procs, MPI_INT, data.data(), vec_size / n_procs, MPI_INT, 0, MPI_COMM_WORLD);
+    for (long long bytes = 8; bytes <= max_bytes; bytes *= 2) {
+        int count = static_cast<int>(bytes / sizeof(int));
+        int num_runs = runs_for_bytes(bytes * n_procs);
+        vector<int> send(static_cast<size_t>(count) * n_procs), out(send.size()), ref(send.size());
+        for (size_t i = 0; i < send.size(); i++) {
+            send[i] = rank * 1000003 + static_cast<int>(i);
+        }
+        MPI_Alltoall(send.data(), count, MPI_INT, ref.data(), count, MPI_INT, MPI_COMM_WORLD);
+
+        auto print = [&](const char* operation, Algo algo, long long total_bytes, double t, bool ok) {
+            if (rank == 0) {
+                std::cout << bytes << "," << operation << "," << algo_name(algo) << "," << t << ","
+                          << total_bytes / t / 1e6 << "," << (ok ? "Yes" : "No") << std::endl;
+            }
+        };
+
+        for (Algo algo : {ALGO_MPI, ALGO_PAIRWISE, ALGO_BRUCK, ALGO_SPREAD_OUT}) {
+            std::fill(out.begin(), out.end(), -1);
+            bench_alltoall(send.data(), out.data(), count, MPI_INT, rank, n_procs, algo);
+            bool ok = all_ranks_agree(out == ref);
+            double t = time_op([&] { bench_alltoall(send.data(), out.data(), count, MPI_INT, rank, n_procs, algo); }, num_runs);
+            print("Alltoall", algo, bytes * n_procs, t, ok);
+        }
+
+        auto skewed = [&](int from, int to) {
+            int units = 1 + (from + to) % 4 + (to == (from + 1) % n_procs ? 8 : 0);
+            return units * count;
+        };
+        vector<int> send_counts(n_procs), send_displs(n_procs), recv_counts(n_procs), recv_displs(n_procs);
+        int send_total = 0, recv_total = 0;
+        for (int p = 0; p < n_procs; p++) {
+            send_counts[p] = skewed(rank, p);
+            recv_counts[p] = skewed(p, rank);
+            send_displs[p] = send_total;
+            recv_displs[p] = recv_total;
+            send_total += send_counts[p];
+            recv_total += recv_counts[p];
+        }
+        vector<int> sendv(send_total), outv(recv_total), refv(recv_total);
+        for (int i = 0; i < send_total; i++) {
+            sendv[i] = rank * 1000003 + i;
+        }
+        long long v_bytes = static_cast<long long>(send_total) * sizeof(int);
+
+        MPI_Alltoallv(sendv.data(), send_counts.data(), send_displs.data(), MPI_INT,
+                      refv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, MPI_COMM_WORLD);
+        double t = time_op([&] {
+            MPI_Alltoallv(sendv.data(), send_counts.data(), send_displs.data(), MPI_INT,
+                          outv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, MPI_COMM_WORLD);
+        }, num_runs);
+        print("Alltoallv", ALGO_MPI, v_bytes, t, true);
+
+        std::fill(outv.begin(), outv.end(), -1);
+        mpi_alltoallv_pairwise(sendv.data(), send_counts.data(), send_displs.data(),
+                               outv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, rank, n_procs);
+        bool ok = all_ranks_agree(outv == refv);
+        t = time_op([&] {
+            mpi_alltoallv_pairwise(sendv.data(), send_counts.data(), send_displs.data(),
+                                   outv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, rank, n_procs);
+        }, num_runs);
+        print("Alltoallv", ALGO_PAIRWISE, v_bytes, t, ok);
+
+        std::fill(outv.begin(), outv.end(), -1);
+        mpi_alltoallv_spread_out(sendv.data(), send_counts.data(), send_displs.data(),
+                                 outv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, rank, n_procs);
+        ok = all_ranks_agree(outv == refv);
+        t = time_op([&] {
+            mpi_alltoallv_spread_out(sendv.data(), send_counts.data(), send_displs.data(),
+                                     outv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, rank, n_procs);
+        }, num_runs);
+        print("Alltoallv", ALGO_SPREAD_OUT, v_bytes, t, ok);
+    }
+}
+
+// Times every algorithm/segment candidate for each message size on the current
+// communicator and replaces this comm size's rules in the decision table.
+// Run it once per rank count (see job9.sh) to fill in the whole table.
+void run_tune(long long max_bytes, const string& path, int rank, int n_procs) {
+    struct Candidate {
+        Algo algo;
+        int seg_bytes;
+    };
+    vector<Candidate> bcast_candidates = {{ALGO_MPI, 0}, {ALGO_BINOMIAL, 0}};
+    for (Algo algo : {ALGO_SEGMENTED, ALGO_CHAIN, ALGO_SCATTER_ALLGATHER}) {
+        for (int seg : {8192, 32768, 131072, 524288}) {
+            bcast_candidates.push_back({algo, seg});
+        }
     }
+    vector<Candidate> allreduce_candidates = {{ALGO_MPI, 0}, {ALGO_RECURSIVE_DOUBLING, 0}, {ALGO_RABENSEIFNER, 0}, {ALGO_RING, 0}};
+
+    vector<TuningRule> bcast_rules, allreduce_rules;
+    auto add_rule = [&](vector<TuningRule>& rules, const string& collective, long long bytes, const Candidate& best) {
+        if (!rules.empty() && rules.back().algo == best.algo && rules.back().seg_bytes == best.seg_bytes) {
+            rules.back().max_bytes = bytes;
+        } else {
+            rules.push_back({collective, n_procs, bytes, best.algo, best.seg_bytes});
+        }
+    };
 
     if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        MPI_Reduce(local_data.data(), data.data(), vec_size / n_procs, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "Reduce (MPI_Reduce)," << elapsed.count() << std::endl;
-    } else {
-        MPI_Reduce(local_data.data(), data.data(), vec_size / n_procs, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+        std::cout << "Collective,Size (bytes),Algorithm,Segment (bytes),Time (seconds)" << std::endl;
+    }
+
+    for (long long bytes = 1024; bytes <= max_bytes; bytes *= 4) {
+        int num_runs = runs_for_bytes(bytes);
+        vector<int> data(bytes / sizeof(int), rank);
+        vector<int> out(data.size());
+        int count = static_cast<int>(data.size());
+
+        double best_time = 0.0;
+        Candidate best = bcast_candidates[0];
+        for (const Candidate& c : bcast_candidates) {
+            int seg_size = max(1, c.seg_bytes / static_cast<int>(sizeof(int)));
+            double t = time_op([&] { bench_bcast(data.data(), count, seg_size, rank, n_procs, c.algo); }, num_runs);
+            if (rank == 0) {
+                std::cout << "bcast," << bytes << "," << algo_name(c.algo) << "," << c.seg_bytes << "," << t << std::endl;
+            }
+            if (&c == &bcast_candidates[0] || t < best_time) {
+                best_time = t;
+                best = c;
+            }
+        }
+        add_rule(bcast_rules, "bcast", bytes, best);
+
+        for (const Candidate& c : allreduce_candidates) {
+            double t = time_op([&] { bench_allreduce(data.data(), out.data(), count, MPI_INT, MPI_SUM, rank, n_procs, c.algo); }, num_runs);
+            if (rank == 0) {
+                std::cout << "allreduce," << bytes << "," << algo_name(c.algo) << ",0," << t << std::endl;
+            }
+            if (&c == &allreduce_candidates[0] || t < best_time) {
+                best_time = t;
+                best = c;
+            }
+        }
+        add_rule(allreduce_rules, "allreduce", bytes, best);
     }
 
+    // Timings are maxima over all ranks, so every rank made the same choices;
+    // rank 0 writes them.
     if (rank == 0) {
-        auto start_time = high_resolution_clock::now();
-        MPI_Allgather(local_data.data(), vec_size / n_procs, MPI_INT, data.data(), vec_size / n_procs, MPI_INT, MPI_COMM_WORLD);
-        auto end_time = high_resolution_clock::now();
-        duration<double> elapsed = end_time - start_time;
-        std::cout << "AllGather (MPI_Allgather)," << elapsed.count() << std::endl;
+        vector<TuningRule> merged;
+        for (const TuningRule& rule : tuning_table) {
+            if (rule.comm_size != n_procs) {
+                merged.push_back(rule);
+            }
+        }
+        merged.insert(merged.end(), bcast_rules.begin(), bcast_rules.end());
+        merged.insert(merged.end(), allreduce_rules.begin(), allreduce_rules.end());
+        tuning_table = merged;
+        save_tuning_table(path);
+    }
+    load_tuning_table(path, rank);
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+
+    int rank, n_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_procs);
+
+    string mode = argc > 1 ? argv[1] : "basic";
+    long long max_bytes = argc > 2 ? atoll(argv[2]) : (256LL << 20);
+    string tuning_path = argc > 3 ? argv[3] : "9_tuning.txt";
+    load_tuning_table(tuning_path, rank);
+
+    if (mode == "tune") {
+        run_tune(argc > 2 ? max_bytes : (64LL << 20), tuning_path, rank, n_procs);
+    } else if (mode == "bcast") {
+        run_bcast_suite(max_bytes, rank, n_procs);
+    } else if (mode == "alltoall") {
+        run_alltoall_suite(argc > 2 ? max_bytes : (1LL << 20), rank, n_procs);
+    } else if (mode == "allreduce") {
+        run_allreduce_suite(argc > 2 ? max_bytes : (1LL << 30), rank, n_procs);
     } else {
-        MPI_Allgather(local_data.data(), vec_size / n_procs, MPI_INT, data.data(), vec_size / n_procs, MPI_INT, MPI_COMM_WORLD);
+        int vec_size = 10000;
+        const int num_runs = 10;
+        run_basic_suite(vec_size, rank, n_procs, num_runs);
     }
 
     MPI_Finalize();
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Process-wide pool of message buffers, so timed loops stop paying for
+// new[]/malloc, page faults and memset on every call. Requests are rounded up
+// to a power-of-two size class of at least one page; blocks are page-aligned
+// and are kept on a per-class free list when a lease ends. With
+// BUFFER_POOL_MPI_ALLOC=1 in the environment, blocks come from MPI_Alloc_mem,
+// which lets the library hand out pre-registered memory. Call
+// buffer_pool().clear() before MPI_Finalize.
+
+const size_t pool_page_size = 4096;
+
+class BufferPool;
+
+class BufferLease {
+public:
+    BufferLease() : pool_(nullptr), data_(nullptr), size_(0), size_class_(0) {}
+    BufferLease(BufferPool* pool, char* data, size_t size, int size_class)
+        : pool_(pool), data_(data), size_(size), size_class_(size_class) {}
+    BufferLease(BufferLease&& other) noexcept
+        : pool_(other.pool_), data_(other.data_), size_(other.size_), size_class_(other.size_class_) {
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+    }
+    BufferLease& operator=(BufferLease&& other) noexcept;
+    BufferLease(const BufferLease&) = delete;
+    BufferLease& operator=(const BufferLease&) = delete;
+    ~BufferLease() { reset(); }
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+    void reset();
+
+private:
+    BufferPool* pool_;
+    char* data_;
+    size_t size_;
+    int size_class_;
+};
+
+class BufferPool {
+public:
+    BufferPool() {
+        const char* env = std::getenv("BUFFER_POOL_MPI_ALLOC");
+        use_mpi_alloc_ = env != nullptr && std::strcmp(env, "1") == 0;
+    }
+    ~BufferPool() { clear(); }
+
+    // A buffer of at least bytes, zero-filled if requested.
+    BufferLease acquire(size_t bytes, bool zero = false) {
+        int size_class = 0;
+        while ((pool_page_size << size_class) < bytes) {
+            ++size_class;
+        }
+        if (free_.size() <= static_cast<size_t>(size_class)) {
+            free_.resize(size_class + 1);
+        }
+        char* block;
+        if (!free_[size_class].empty()) {
+            block = free_[size_class].back();
+            free_[size_class].pop_back();
+        } else {
+            block = allocate(pool_page_size << size_class);
+        }
+        if (zero) {
+            std::memset(block, 0, bytes);
+        }
+        return BufferLease(this, block, bytes, size_class);
+    }
+
+    void give_back(char* block, int size_class) {
+        free_[size_class].push_back(block);
+    }
+
+    // Frees every idle block. Leases still out are unaffected.
+    void clear() {
+        for (auto& blocks : free_) {
+            for (char* block : blocks) {
+                deallocate(block);
+            }
+            blocks.clear();
+        }
+    }
+
+    bool uses_mpi_alloc() const { return use_mpi_alloc_; }
+
+private:
+    char* allocate(size_t bytes) {
+        void* p = nullptr;
+        if (use_mpi_alloc_) {
+            MPI_Alloc_mem(static_cast<MPI_Aint>(bytes), MPI_INFO_NULL, &p);
+        } else if (posix_memalign(&p, pool_page_size, bytes) != 0) {
+            p = nullptr;
+        }
+        if (p == nullptr) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        return static_cast<char*>(p);
+    }
+
+    void deallocate(char* block) {
+        if (use_mpi_alloc_) {
+            MPI_Free_mem(block);
+        } else {
+            std::free(block);
+        }
+    }
+
+    bool use_mpi_alloc_;
+    std::vector<std::vector<char*>> free_;
+};
+
+inline BufferLease& BufferLease::operator=(BufferLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        size_ = other.size_;
+        size_class_ = other.size_class_;
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+inline void BufferLease::reset() {
+    if (pool_ != nullptr) {
+        pool_->give_back(data_, size_class_);
+        pool_ = nullptr;
+        data_ = nullptr;
+    }
+}
+
+inline BufferPool& buffer_pool() {
+    static BufferPool pool;
+    return pool;
+}
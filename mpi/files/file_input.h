@@ -0,0 +1,89 @@
+#pragma once
+
+#include <mpi.h>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../../open_mp/dataset.h"
+
+// Collective MPI-IO input for the binary format from open_mp/dataset.h
+// (written by open_mp/gen_dataset). Every rank reads its own block of the
+// shared file with MPI_File_set_view + MPI_File_read_at_all, so nothing has
+// to be read by rank 0 and scattered. Vectors are rows of the file, and a
+// matrix block is a range of rows whose stride padding is skipped by the
+// file view.
+
+struct FileInput {
+    MPI_File fh;
+    DatasetHeader header;
+};
+
+// First index of part `index` when n items are split into `parts` blocks.
+inline long long file_block_start(int index, long long n, int parts) {
+    return n * index / parts;
+}
+
+// Collective. Returns false on every rank if the file cannot be used.
+inline bool file_input_open(const char* path, FileInput& in, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &in.fh) != MPI_SUCCESS) {
+        if (rank == 0) {
+            std::cerr << "Cannot open " << path << std::endl;
+        }
+        return false;
+    }
+    std::memset(&in.header, 0, sizeof(in.header));
+    MPI_File_read_at_all(in.fh, 0, &in.header, sizeof(in.header), MPI_BYTE, MPI_STATUS_IGNORE);
+
+    const DatasetHeader& h = in.header;
+    bool ok = std::memcmp(h.magic, dataset_magic, sizeof(h.magic)) == 0 && h.version == dataset_version &&
+              h.type == DATASET_INT32 && h.elem_size == sizeof(int) && h.stride >= h.cols;
+    if (!ok) {
+        if (rank == 0) {
+            std::cerr << path << " is not an int dataset file" << std::endl;
+        }
+        MPI_File_close(&in.fh);
+    }
+    return ok;
+}
+
+// Collective. Reads elements [first, first + count) of `row` into buf.
+inline void file_input_read_slice(FileInput& in, int row, long long first, int count, int* buf) {
+    MPI_Offset disp = in.header.data_offset + (row * in.header.stride + first) * sizeof(int);
+    MPI_File_set_view(in.fh, disp, MPI_INT, MPI_INT, "native", MPI_INFO_NULL);
+    MPI_File_read_at_all(in.fh, 0, buf, count, MPI_INT, MPI_STATUS_IGNORE);
+}
+
+// Collective. This rank's block of `row` when the row is split evenly over
+// the ranks of the file's communicator.
+inline std::vector<int> file_input_read_block(FileInput& in, int row, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    long long n = static_cast<long long>(in.header.cols);
+    long long first = file_block_start(rank, n, size);
+    std::vector<int> block(file_block_start(rank + 1, n, size) - first);
+    file_input_read_slice(in, row, first, static_cast<int>(block.size()), block.data());
+    return block;
+}
+
+// Collective. Reads `rows` matrix rows starting at first_row into buf,
+// packed as rows x cols.
+inline void file_input_read_rows(FileInput& in, long long first_row, int rows, int* buf) {
+    MPI_Datatype line, row_type;
+    MPI_Type_contiguous(static_cast<int>(in.header.cols), MPI_INT, &line);
+    MPI_Type_create_resized(line, 0, static_cast<MPI_Aint>(in.header.stride * sizeof(int)), &row_type);
+    MPI_Type_commit(&row_type);
+
+    MPI_Offset disp = in.header.data_offset + first_row * in.header.stride * sizeof(int);
+    MPI_File_set_view(in.fh, disp, MPI_INT, row_type, "native", MPI_INFO_NULL);
+    MPI_File_read_at_all(in.fh, 0, buf, rows * static_cast<int>(in.header.cols), MPI_INT, MPI_STATUS_IGNORE);
+
+    MPI_Type_free(&row_type);
+    MPI_Type_free(&line);
+}
+
+inline void file_input_close(FileInput& in) {
+    MPI_File_close(&in.fh);
+}
@@ -0,0 +1,11 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ -O2 -fopenmp 12.cpp -o 12
+export OMP_NUM_THREADS=4
+mpirun ./12
+
+
+
+
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ -O2 13.cpp -o 13
+mpirun ./13
+
+
+
+
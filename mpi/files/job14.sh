@@ -0,0 +1,10 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ 14.cpp -o 14
+mpirun ./14
+
+
+
+
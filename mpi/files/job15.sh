@@ -0,0 +1,12 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ 15.cpp -o 15
+for np in 8 16 32; do
+    mpirun -np $np ./15
+done
+
+
+
+
@@ -0,0 +1,12 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ -O2 16.cpp -o 16
+for np in 8 16 32; do
+    mpirun -np $np ./16
+done
+
+
+
+
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+module load gcc/9
+module load openmpi
+mpic++ -O2 17.cpp -o 17
+mpirun ./17
+
+
+
+
@@ -3,7 +3,9 @@
 module load gcc/9
 module load openmpi
 mpic++ 5.cpp -o 5
-mpirun ./5
+for np in 8 16 32; do
+    mpirun -np $np ./5
+done
 
 
 
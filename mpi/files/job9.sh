@@ -3,7 +3,15 @@
 module load gcc/9
 module load openmpi
 mpic++ 9.cpp -o 9
+for np in 8 16 32; do
+    mpirun -np $np ./9 tune
+done
 mpirun ./9
+mpirun ./9 bcast
+mpirun ./9 allreduce
+for np in 8 16 32; do
+    mpirun -np $np ./9 alltoall
+done
 
 
 
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <mpi.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Input vectors held once per node in an MPI_Win_allocate_shared window
+// instead of being scattered into a private copy on every rank. The node
+// leader (node rank 0) owns the window memory; on the root's node it holds the
+// whole input, written there directly by world rank 0, and on any other node
+// only the slices of that node's ranks, which arrive with one MPI_Scatterv
+// between leaders. Every rank reads its slice in place through
+// MPI_Win_shared_query. The slices cover the same first size * local_size
+// elements as MPI_Scatter only if ranks are numbered node by node; setup
+// checks that, and with any other placement (--map-by node, cyclic Slurm
+// distribution) every rank gets a window of its own, so the input is
+// scattered between all ranks as with MPI_Scatter.
+
+struct SharedInput {
+    MPI_Comm node_comm;
+    MPI_Comm leader_comm;
+    MPI_Win win;
+    int* base;
+    int node_rank, node_size;
+    int arrays;
+    long long capacity;
+};
+
+inline SharedInput shared_input_create(int N, int local_size, int arrays, int world_rank) {
+    SharedInput s;
+    s.arrays = arrays;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank, MPI_INFO_NULL, &s.node_comm);
+    MPI_Comm_rank(s.node_comm, &s.node_rank);
+    MPI_Comm_size(s.node_comm, &s.node_size);
+
+    int leader_world_rank = world_rank;
+    MPI_Bcast(&leader_world_rank, 1, MPI_INT, 0, s.node_comm);
+    int blocked = world_rank == leader_world_rank + s.node_rank, all_blocked = 0;
+    MPI_Allreduce(&blocked, &all_blocked, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (!all_blocked) {
+        if (world_rank == 0) {
+            std::cerr << "Ranks are not numbered node by node; shared input falls back to a copy per rank" << std::endl;
+        }
+        MPI_Comm_free(&s.node_comm);
+        MPI_Comm_split(MPI_COMM_WORLD, world_rank, 0, &s.node_comm);
+        s.node_rank = 0;
+        s.node_size = 1;
+    }
+    MPI_Comm_split(MPI_COMM_WORLD, s.node_rank == 0 ? 0 : MPI_UNDEFINED, world_rank, &s.leader_comm);
+
+    long long node_elems = static_cast<long long>(s.node_size) * local_size;
+    s.capacity = world_rank == 0 ? N : node_elems;
+    MPI_Aint bytes = s.node_rank == 0 ? static_cast<MPI_Aint>(s.capacity) * arrays * sizeof(int) : 0;
+    int* own;
+    MPI_Win_allocate_shared(bytes, sizeof(int), MPI_INFO_NULL, s.node_comm, &own, &s.win);
+
+    MPI_Aint size;
+    int disp_unit;
+    MPI_Win_shared_query(s.win, 0, &size, &disp_unit, &s.base);
+    MPI_Bcast(&s.capacity, 1, MPI_LONG_LONG, 0, s.node_comm);
+
+    // Loads and stores go straight to memory; the epoch only allows
+    // MPI_Win_sync to order them.
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, s.win);
+    return s;
+}
+
+// Where world rank 0 writes input array a before shared_input_distribute.
+inline int* shared_input_root_array(SharedInput& s, int a) {
+    return s.base + a * s.capacity;
+}
+
+// Sends other nodes their slices and makes the root's writes visible on
+// every node.
+inline void shared_input_distribute(SharedInput& s, int local_size) {
+    if (s.leader_comm != MPI_COMM_NULL) {
+        int leader_rank, leaders;
+        MPI_Comm_rank(s.leader_comm, &leader_rank);
+        MPI_Comm_size(s.leader_comm, &leaders);
+        if (leaders > 1) {
+            int count = s.node_size * local_size;
+            std::vector<int> counts(leaders), displs(leaders);
+            MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, s.leader_comm);
+            for (int l = 1; l < leaders; ++l) {
+                displs[l] = displs[l - 1] + counts[l - 1];
+            }
+            for (int a = 0; a < s.arrays; ++a) {
+                int* array = s.base + a * s.capacity;
+                if (leader_rank == 0) {
+                    MPI_Scatterv(array, counts.data(), displs.data(), MPI_INT,
+                                 MPI_IN_PLACE, count, MPI_INT, 0, s.leader_comm);
+                } else {
+                    MPI_Scatterv(nullptr, nullptr, nullptr, MPI_INT, array, count, MPI_INT, 0, s.leader_comm);
+                }
+            }
+        }
+    }
+    MPI_Win_sync(s.win);
+    MPI_Barrier(s.node_comm);
+    MPI_Win_sync(s.win);
+}
+
+inline const int* shared_input_slice(const SharedInput& s, int a, int local_size) {
+    return s.base + a * s.capacity + static_cast<long long>(s.node_rank) * local_size;
+}
+
+inline void shared_input_free(SharedInput& s) {
+    MPI_Win_unlock_all(s.win);
+    MPI_Win_free(&s.win);
+    if (s.leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&s.leader_comm);
+    }
+    MPI_Comm_free(&s.node_comm);
+}
+
+// Proportional set size of this process in KB: shared pages are divided among
+// the processes mapping them, so the sum over ranks is the real footprint.
+// Falls back to VmRSS where smaps_rollup is missing.
+inline long resident_kb() {
+    const char* sources[2][2] = {{"/proc/self/smaps_rollup", "Pss:"}, {"/proc/self/status", "VmRSS:"}};
+    for (auto& source : sources) {
+        std::ifstream in(source[0]);
+        std::string key;
+        long value;
+        while (in >> key) {
+            if (key == source[1] && in >> value) {
+                return value;
+            }
+        }
+    }
+    return 0;
+}
@@ -4,13 +4,14 @@
 #include <limits>
 #include <chrono>
 #include <fstream>
+#include "dataset.h"
 
-void no_reduction_method(const std::vector<int> &vec, int &max_val, int &min_val) {
+void no_reduction_method(const int *vec, size_t size, int &max_val, int &min_val) {
     max_val = std::numeric_limits<int>::min();
     min_val = std::numeric_limits<int>::max();
 
 #pragma omp parallel for
-    for (int i = 0; i < vec.size(); i++) {
+    for (size_t i = 0; i < size; i++) {
 #pragma omp critical
         {
             if (vec[i] > max_val)
@@ -21,12 +22,12 @@ void no_reduction_method(const std::vector<int> &vec, int &max_val, int &min_val
     }
 }
 
-void reduction_method(const std::vector<int> &vec, int &max_val, int &min_val) {
+void reduction_method(const int *vec, size_t size, int &max_val, int &min_val) {
     max_val = std::numeric_limits<int>::min();
     min_val = std::numeric_limits<int>::max();
 
 #pragma omp parallel for reduction(max : max_val) reduction(min : min_val)
-    for (int i = 0; i < vec.size(); i++) {
+    for (size_t i = 0; i < size; i++) {
         if (vec[i] > max_val)
             max_val = vec[i];
         if (vec[i] < min_val)
@@ -34,11 +35,11 @@ void reduction_method(const std::vector<int> &vec, int &max_val, int &min_val) {
     }
 }
 
-void sequential_method(const std::vector<int> &vec, int &max_val, int &min_val) {
+void sequential_method(const int *vec, size_t size, int &max_val, int &min_val) {
     max_val = std::numeric_limits<int>::min();
     min_val = std::numeric_limits<int>::max();
 
-    for (int i = 0; i < vec.size(); i++) {
+    for (size_t i = 0; i < size; i++) {
         if (vec[i] > max_val)
             max_val = vec[i];
         if (vec[i] < min_val)
@@ -46,7 +47,50 @@ void sequential_method(const std::vector<int> &vec, int &max_val, int &min_val)
     }
 }
 
-int main() {
+void run_tests(std::ofstream &log_file, const int *vec, size_t size, int num_tests) {
+    int max_val, min_val;
+
+    // Sequential method
+    double sequential_time = 0.0;
+    for (int i = 0; i < num_tests; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        sequential_method(vec, size, max_val, min_val);
+        auto end = std::chrono::high_resolution_clock::now();
+        sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    sequential_time /= num_tests;
+
+    // No reduction method
+    double no_reduction_time = 0.0;
+    for (int i = 0; i < num_tests; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        no_reduction_method(vec, size, max_val, min_val);
+        auto end = std::chrono::high_resolution_clock::now();
+        no_reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    no_reduction_time /= num_tests;
+
+    // Reduction method
+    double reduction_time = 0.0;
+    for (int i = 0; i < num_tests; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        reduction_method(vec, size, max_val, min_val);
+        auto end = std::chrono::high_resolution_clock::now();
+        reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    reduction_time /= num_tests;
+
+    // Log results
+    log_file << "Vector size: " << size << "\n";
+    log_file << "Sequential method time: " << sequential_time << " ms\n";
+    log_file << "No reduction method time: " << no_reduction_time << " ms\n";
+    log_file << "Reduction method time: " << reduction_time << " ms\n";
+    log_file << "--------------------------------------\n";
+}
+
+// ./1 [dataset [sequential]] — без аргументов векторы генерируются rand(),
+// иначе берётся первая строка файла (см. gen_dataset.cpp).
+int main(int argc, char **argv) {
     std::ofstream log_file("1_log.txt");
     if (!log_file.is_open()) {
         std::cerr << "Failed to open log file!" << std::endl;
@@ -55,52 +99,30 @@ int main() {
 
     const int num_tests = 5;
 
+    if (argc > 1) {
+        auto start = std::chrono::high_resolution_clock::now();
+        DatasetView<int> data = dataset_open<int>(argv[1], dataset_access_from_arg(argc, argv, 2));
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!data.ok()) {
+            return 1;
+        }
+        log_file << "Dataset: " << argv[1] << "\n";
+        log_file << "Dataset open time: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+        run_tests(log_file, data[0], static_cast<size_t>(data.cols), num_tests);
+        dataset_close(data);
+        log_file.close();
+        return 0;
+    }
+
     for (size_t size : {1000, 10000, 100000, 1000000, 10000000}) {
         std::vector<int> vec(size);
         for (size_t i = 0; i < size; i++) {
             vec[i] = rand() % 1000000; // Fill with random values
         }
 
-        int max_val, min_val;
-
-        // Sequential method
-        double sequential_time = 0.0;
-        for (int i = 0; i < num_tests; i++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            sequential_method(vec, max_val, min_val);
-            auto end = std::chrono::high_resolution_clock::now();
-            sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        sequential_time /= num_tests;
-
-        // No reduction method
-        double no_reduction_time = 0.0;
-        for (int i = 0; i < num_tests; i++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            no_reduction_method(vec, max_val, min_val);
-            auto end = std::chrono::high_resolution_clock::now();
-            no_reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        no_reduction_time /= num_tests;
-
-        // Reduction method
-        double reduction_time = 0.0;
-        for (int i = 0; i < num_tests; i++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            reduction_method(vec, max_val, min_val);
-            auto end = std::chrono::high_resolution_clock::now();
-            reduction_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        reduction_time /= num_tests;
-
-        // Log results
-        log_file << "Vector size: " << size << "\n";
-        log_file << "Sequential method time: " << sequential_time << " ms\n";
-        log_file << "No reduction method time: " << no_reduction_time << " ms\n";
-        log_file << "Reduction method time: " << reduction_time << " ms\n";
-        log_file << "--------------------------------------\n";
+        run_tests(log_file, vec.data(), size, num_tests);
     }
 
     log_file.close();
     return 0;
-}
+}
\ No newline at end of file
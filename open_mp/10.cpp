@@ -0,0 +1,216 @@
+#include <iostream>
+#include <vector>
+#include <omp.h>
+#include <limits>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "huge_alloc.h"
+
+// Скалярное произведение из 2.cpp и максимум минимумов из 4.cpp на данных,
+// выделенных обычными 4 КБ страницами, THP и HUGETLB. Для каждого режима
+// пишется время и доля промахов dTLB (perf_event_open, счётчики наследуются
+// потоками OpenMP). Обход матрицы по столбцам добавлен как худший для TLB
+// случай: каждое обращение попадает на новую 4 КБ страницу.
+
+// Счётчики dTLB-загрузок и dTLB-промахов для процесса и его потоков.
+// Открываются до первой параллельной секции, иначе потоки пула не унаследуют их.
+struct TlbCounter {
+    int loads_fd = -1;
+    int misses_fd = -1;
+
+    bool available() const { return loads_fd >= 0 && misses_fd >= 0; }
+};
+
+int open_counter(unsigned long long result) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+TlbCounter open_tlb_counter() {
+    TlbCounter c;
+    c.loads_fd = open_counter(PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+    c.misses_fd = open_counter(PERF_COUNT_HW_CACHE_RESULT_MISS);
+    if (!c.available()) {
+        if (c.loads_fd >= 0) close(c.loads_fd);
+        if (c.misses_fd >= 0) close(c.misses_fd);
+        c.loads_fd = c.misses_fd = -1;
+    }
+    return c;
+}
+
+long long read_counter(int fd) {
+    long long value = 0;
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+struct Measurement {
+    double time_ms;
+    double miss_rate;  // < 0, если счётчики недоступны
+};
+
+Measurement measure(const TlbCounter& counter, int num_tests, const std::function<void()>& kernel) {
+    if (counter.available()) {
+        ioctl(counter.loads_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.misses_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.loads_fd, PERF_EVENT_IOC_ENABLE, 0);
+        ioctl(counter.misses_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_tests; i++) {
+        kernel();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    Measurement m = {std::chrono::duration<double, std::milli>(end - start).count() / num_tests, -1.0};
+    if (counter.available()) {
+        ioctl(counter.loads_fd, PERF_EVENT_IOC_DISABLE, 0);
+        ioctl(counter.misses_fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long loads = read_counter(counter.loads_fd);
+        long long misses = read_counter(counter.misses_fd);
+        m.miss_rate = loads > 0 ? static_cast<double>(misses) / loads : 0.0;
+    }
+    return m;
+}
+
+void log_measurement(std::ofstream& log_file, const std::string& name, const Measurement& m) {
+    log_file << name << " time: " << m.time_ms << " ms" << std::endl;
+    log_file << name << " dTLB miss rate: ";
+    if (m.miss_rate < 0) {
+        log_file << "n/a";
+    } else {
+        log_file << m.miss_rate * 100 << " %";
+    }
+    log_file << std::endl;
+}
+
+long long dot_product(const huge_vector<int>& vec1, const huge_vector<int>& vec2) {
+    long long dot = 0;
+    long long size = static_cast<long long>(vec1.size());
+    #pragma omp parallel for reduction(+:dot)
+    for (long long i = 0; i < size; i++) {
+        dot += vec1[i] * vec2[i];
+    }
+    return dot;
+}
+
+int max_of_row_mins(const HugeMatrix<int>& matrix) {
+    int max_of_mins = std::numeric_limits<int>::min();
+    #pragma omp parallel for reduction(max:max_of_mins)
+    for (int i = 0; i < matrix.rows; i++) {
+        int min_in_row = std::numeric_limits<int>::max();
+        for (int j = 0; j < matrix.cols; j++) {
+            if (matrix[i][j] < min_in_row) min_in_row = matrix[i][j];
+        }
+        if (min_in_row > max_of_mins) max_of_mins = min_in_row;
+    }
+    return max_of_mins;
+}
+
+int max_of_col_mins(const HugeMatrix<int>& matrix) {
+    int max_of_mins = std::numeric_limits<int>::min();
+    #pragma omp parallel for reduction(max:max_of_mins)
+    for (int j = 0; j < matrix.cols; j++) {
+        int min_in_col = std::numeric_limits<int>::max();
+        for (int i = 0; i < matrix.rows; i++) {
+            if (matrix[i][j] < min_in_col) min_in_col = matrix[i][j];
+        }
+        if (min_in_col > max_of_mins) max_of_mins = min_in_col;
+    }
+    return max_of_mins;
+}
+
+int main() {
+    TlbCounter counter = open_tlb_counter();
+
+    std::ofstream log_file("10_log.txt");
+    if (!log_file.is_open()) {
+        std::cerr << "Failed to open log file!" << std::endl;
+        return 1;
+    }
+
+    const long long vec_size = 100000000;
+    const int matrix_size = 10000;
+    const int num_tests = 5;
+
+    if (!counter.available()) {
+        log_file << "dTLB counters are not available (perf_event_open failed), miss rates are n/a" << std::endl;
+    }
+
+    for (PageMode mode : {PAGES_SMALL, PAGES_THP, PAGES_HUGETLB}) {
+        PageMode obtained = mode;
+        void* probe = huge_alloc(huge_page_size, mode, &obtained);
+        huge_free(probe, huge_page_size);
+
+        // Время включает выделение и первое касание всех страниц.
+        auto start = std::chrono::high_resolution_clock::now();
+        huge_vector<int> vec1(vec_size, 0, HugePageAllocator<int>(mode));
+        huge_vector<int> vec2(vec_size, 0, HugePageAllocator<int>(mode));
+        HugeMatrix<int> matrix(matrix_size, matrix_size, 0, mode);
+        #pragma omp parallel for
+        for (long long i = 0; i < vec_size; i++) {
+            vec1[i] = 1;
+            vec2[i] = 2;
+        }
+        #pragma omp parallel for
+        for (int i = 0; i < matrix_size; i++) {
+            for (int j = 0; j < matrix_size; j++) {
+                matrix[i][j] = (i * 31 + j * 17) % 1000;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double alloc_time = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // Соседние отображения ядро может склеить в одно, поэтому smaps
+        // смотрится один раз по всему диапазону, занятому тремя блоками.
+        const char* blocks[3][2] = {
+            {reinterpret_cast<const char*>(vec1.data()), reinterpret_cast<const char*>(vec1.data() + vec1.size())},
+            {reinterpret_cast<const char*>(vec2.data()), reinterpret_cast<const char*>(vec2.data() + vec2.size())},
+            {reinterpret_cast<const char*>(matrix.data.data()), reinterpret_cast<const char*>(matrix.data.data() + matrix.data.size())}};
+        const char* lo = blocks[0][0];
+        const char* hi = blocks[0][1];
+        for (auto& block : blocks) {
+            lo = std::min(lo, block[0]);
+            hi = std::max(hi, block[1]);
+        }
+        long total_kb = static_cast<long>((2 * vec_size + matrix.data.size()) * sizeof(int) / 1024);
+        long huge_kb = std::min(huge_backed_kb(lo, hi - lo), total_kb);
+
+        long long dot = 0;
+        int row_result = 0, col_result = 0;
+        Measurement dot_m = measure(counter, num_tests, [&] { dot = dot_product(vec1, vec2); });
+        Measurement row_m = measure(counter, num_tests, [&] { row_result = max_of_row_mins(matrix); });
+        Measurement col_m = measure(counter, num_tests, [&] { col_result = max_of_col_mins(matrix); });
+
+        log_file << "Page mode: " << page_mode_name(mode) << " (obtained: " << page_mode_name(obtained) << ")" << std::endl;
+        log_file << "Huge-page backed: " << huge_kb / 1024 << " of " << total_kb / 1024 << " MB" << std::endl;
+        log_file << "Allocation and first touch time: " << alloc_time << " ms" << std::endl;
+        log_file << "Dot product (" << vec_size << " ints, result " << dot << ")" << std::endl;
+        log_measurement(log_file, "Dot product", dot_m);
+        log_file << "Max of row mins (" << matrix_size << "x" << matrix_size << ", result " << row_result << ")" << std::endl;
+        log_measurement(log_file, "Row traversal", row_m);
+        log_file << "Max of column mins (result " << col_result << ")" << std::endl;
+        log_measurement(log_file, "Column traversal", col_m);
+        log_file << "--------------------------------------" << std::endl;
+    }
+
+    log_file.close();
+    return 0;
+}
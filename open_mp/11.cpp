@@ -0,0 +1,293 @@
+#include <iostream>
+#include <vector>
+#include <omp.h>
+#include <limits>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "huge_alloc.h"
+#include "dataset.h"
+
+// Минимум/максимум (как в 1.cpp) и скалярное произведение (как в 2.cpp) над
+// векторами из файла, которые не обязаны помещаться в память. Файл читается
+// кусками фиксированного размера фоновым потоком через pread в кольцо из depth
+// буферов: пока OpenMP-ядро обрабатывает кусок k, следующие куски уже
+// читаются. Частичные результаты кусков сводятся в общий.
+//
+//   ./11 <dataset> [chunk_mb]
+// Файл — из gen_dataset.cpp: строка 0 — вектор для min/max, строки 0 и 1 —
+// пара векторов для скалярного произведения (если rows >= 2).
+// Перед каждым проходом файл выбрасывается из page cache (posix_fadvise),
+// чтобы чтение шло с диска, а не из памяти.
+
+// Кольцо буферов, которое заполняет фоновый поток. Каждый кусок состоит из
+// одинаковых отрезков нескольких потоков данных (строк файла), начинающихся
+// со смещений bases.
+class ChunkStream {
+public:
+    ChunkStream(int fd, const std::vector<off_t>& bases, size_t total_bytes, size_t chunk_bytes, int depth)
+        : fd_(fd), bases_(bases), total_bytes_(total_bytes), chunk_bytes_(chunk_bytes),
+          num_chunks_((total_bytes + chunk_bytes - 1) / chunk_bytes), slots_(depth) {
+        for (Slot& slot : slots_) {
+            slot.buf = static_cast<char*>(huge_alloc(chunk_bytes_ * bases_.size(), PAGES_THP));
+            if (slot.buf == nullptr) {
+                // Без буферов фоновый поток не запускается, acquire сразу вернёт 0.
+                std::cerr << "Cannot allocate " << slots_.size() << " buffers of "
+                          << chunk_bytes_ * bases_.size() / (1024 * 1024) << " MB" << std::endl;
+                failed = true;
+                return;
+            }
+        }
+        io_thread_ = std::thread(&ChunkStream::io_loop, this);
+    }
+
+    ~ChunkStream() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (io_thread_.joinable()) {
+            io_thread_.join();
+        }
+        for (Slot& slot : slots_) {
+            huge_free(slot.buf, chunk_bytes_ * bases_.size());
+        }
+    }
+
+    // Ждёт следующий кусок; parts[i] — его отрезок i-го потока данных.
+    // Возвращает длину отрезка в байтах, 0 — данные кончились или ошибка чтения.
+    size_t acquire(std::vector<const char*>& parts) {
+        if (failed || next_ == num_chunks_) {
+            return 0;
+        }
+        Slot& slot = slots_[next_ % slots_.size()];
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return slot.full; });
+        }
+        wait_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (slot.failed) {
+            failed = true;
+            return 0;
+        }
+        parts.resize(bases_.size());
+        for (size_t i = 0; i < bases_.size(); i++) {
+            parts[i] = slot.buf + i * chunk_bytes_;
+        }
+        return slot.bytes;
+    }
+
+    // Отдаёт текущий кусок обратно фоновому потоку.
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_[next_ % slots_.size()].full = false;
+        }
+        next_++;
+        cv_.notify_all();
+    }
+
+    double wait_time = 0.0; // сколько ядро простаивало в ожидании данных, с
+    bool failed = false;
+
+private:
+    struct Slot {
+        char* buf = nullptr;
+        size_t bytes = 0;
+        bool full = false;
+        bool failed = false;
+    };
+
+    bool read_full(char* buf, size_t bytes, off_t offset) {
+        while (bytes > 0) {
+            ssize_t got = pread(fd_, buf, bytes, offset);
+            if (got <= 0) {
+                return false;
+            }
+            buf += got;
+            bytes -= got;
+            offset += got;
+        }
+        return true;
+    }
+
+    void io_loop() {
+        for (size_t k = 0; k < num_chunks_; k++) {
+            Slot& slot = slots_[k % slots_.size()];
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || !slot.full; });
+                if (stop_) {
+                    return;
+                }
+            }
+            size_t bytes = std::min(chunk_bytes_, total_bytes_ - k * chunk_bytes_);
+            bool ok = true;
+            for (size_t i = 0; ok && i < bases_.size(); i++) {
+                ok = read_full(slot.buf + i * chunk_bytes_, bytes, bases_[i] + static_cast<off_t>(k * chunk_bytes_));
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                slot.bytes = bytes;
+                slot.failed = !ok;
+                slot.full = true;
+            }
+            cv_.notify_all();
+            if (!ok) {
+                return;
+            }
+        }
+    }
+
+    int fd_;
+    std::vector<off_t> bases_;
+    size_t total_bytes_;
+    size_t chunk_bytes_;
+    size_t num_chunks_;
+    size_t next_ = 0;
+    std::vector<Slot> slots_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread io_thread_;
+};
+
+struct PassResult {
+    double time;      // с
+    double wait_time; // с
+    bool ok;
+};
+
+// Один проход по файлу: chunk_kernel(parts, count) вызывается для каждого
+// куска, count — число элементов в каждом отрезке.
+template <typename Kernel>
+PassResult stream_pass(int fd, const std::vector<off_t>& bases, size_t total_bytes, size_t chunk_bytes,
+                       int depth, Kernel chunk_kernel) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    auto start = std::chrono::high_resolution_clock::now();
+    ChunkStream stream(fd, bases, total_bytes, chunk_bytes, depth);
+    std::vector<const char*> parts;
+    size_t bytes;
+    while ((bytes = stream.acquire(parts)) > 0) {
+        chunk_kernel(parts, bytes / sizeof(int));
+        stream.release();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return {std::chrono::duration<double>(end - start).count(), stream.wait_time, !stream.failed};
+}
+
+void log_pass(std::ofstream& log_file, const std::string& name, const PassResult& pass, double bytes, double disk_gbps) {
+    double gbps = bytes / pass.time / 1e9;
+    log_file << name << " time: " << pass.time * 1000 << " ms" << std::endl;
+    log_file << name << " effective bandwidth: " << gbps << " GB/s (" << gbps / disk_gbps * 100 << " % of disk)" << std::endl;
+    log_file << name << " waiting for I/O: " << pass.wait_time * 1000 << " ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <dataset> [chunk_mb]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    size_t chunk_bytes = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64) * 1024 * 1024;
+    chunk_bytes = std::max(chunk_bytes, huge_page_size);
+
+    std::ofstream log_file("11_log.txt");
+    if (!log_file.is_open()) {
+        std::cerr << "Failed to open log file!" << std::endl;
+        return 1;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open dataset " << path << std::endl;
+        return 1;
+    }
+    DatasetHeader header;
+    size_t length;
+    if (!dataset_read_header<int>(path, fd, header, length)) {
+        close(fd);
+        return 1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    size_t vec_bytes = header.cols * sizeof(int);
+    off_t row0 = static_cast<off_t>(header.data_offset);
+    off_t row1 = row0 + static_cast<off_t>(header.stride * sizeof(int));
+    std::vector<int> depths = {1, 2, 3};
+
+    log_file << "Dataset: " << path << " (" << header.rows << "x" << header.cols << ")" << std::endl;
+    log_file << "Chunk size: " << chunk_bytes / (1024 * 1024) << " MB" << std::endl;
+
+    // Скорость диска: тот же конвейер без вычислений.
+    PassResult read_only = stream_pass(fd, {row0}, vec_bytes, chunk_bytes, 2, [](const std::vector<const char*>&, size_t) {});
+    if (!read_only.ok) {
+        std::cerr << "Failed to read " << path << std::endl;
+        return 1;
+    }
+    double disk_gbps = vec_bytes / read_only.time / 1e9;
+    log_file << "Disk read bandwidth (pread, no compute): " << disk_gbps << " GB/s" << std::endl;
+    log_file << "--------------------------------------" << std::endl;
+
+    for (int depth : depths) {
+        int max_val = std::numeric_limits<int>::min();
+        int min_val = std::numeric_limits<int>::max();
+        PassResult pass = stream_pass(fd, {row0}, vec_bytes, chunk_bytes, depth,
+                                      [&](const std::vector<const char*>& parts, size_t count) {
+            const int* vec = reinterpret_cast<const int*>(parts[0]);
+            int chunk_max = max_val, chunk_min = min_val;
+            #pragma omp parallel for reduction(max : chunk_max) reduction(min : chunk_min)
+            for (size_t i = 0; i < count; i++) {
+                if (vec[i] > chunk_max) chunk_max = vec[i];
+                if (vec[i] < chunk_min) chunk_min = vec[i];
+            }
+            max_val = chunk_max;
+            min_val = chunk_min;
+        });
+        if (!pass.ok) {
+            std::cerr << "Failed to read " << path << std::endl;
+            return 1;
+        }
+        log_file << "Min/max, buffers: " << depth << (depth == 1 ? " (no prefetch)" : "")
+                 << ", min " << min_val << ", max " << max_val << std::endl;
+        log_pass(log_file, "Min/max", pass, static_cast<double>(vec_bytes), disk_gbps);
+        log_file << "--------------------------------------" << std::endl;
+    }
+
+    if (header.rows >= 2) {
+        for (int depth : depths) {
+            long long dot_product = 0;
+            PassResult pass = stream_pass(fd, {row0, row1}, vec_bytes, chunk_bytes, depth,
+                                          [&](const std::vector<const char*>& parts, size_t count) {
+                const int* vec1 = reinterpret_cast<const int*>(parts[0]);
+                const int* vec2 = reinterpret_cast<const int*>(parts[1]);
+                long long chunk_dot = 0;
+                #pragma omp parallel for reduction(+ : chunk_dot)
+                for (size_t i = 0; i < count; i++) {
+                    chunk_dot += static_cast<long long>(vec1[i]) * vec2[i];
+                }
+                dot_product += chunk_dot;
+            });
+            if (!pass.ok) {
+                std::cerr << "Failed to read " << path << std::endl;
+                return 1;
+            }
+            log_file << "Dot product, buffers: " << depth << (depth == 1 ? " (no prefetch)" : "")
+                     << ", result " << dot_product << std::endl;
+            log_pass(log_file, "Dot product", pass, 2.0 * vec_bytes, disk_gbps);
+            log_file << "--------------------------------------" << std::endl;
+        }
+    }
+
+    close(fd);
+    log_file.close();
+    return 0;
+}
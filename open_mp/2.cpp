@@ -3,50 +3,77 @@
 #include <omp.h>
 #include <chrono>
 #include <fstream>
+#include "huge_alloc.h"
+#include "dataset.h"
 
-int main() {
+void run_tests(std::ofstream& log_file, const int* vec1, const int* vec2, long long size, int num_runs) {
+    long long dot_product = 0;
+
+    // Sequential method
+    double total_sequential_time = 0;
+    for (int run = 0; run < num_runs; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        dot_product = 0;
+        for (long long i = 0; i < size; i++) {
+            dot_product += static_cast<long long>(vec1[i]) * vec2[i];
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> sequential_time = end - start;
+        total_sequential_time += sequential_time.count();
+    }
+    double average_sequential_time = total_sequential_time / num_runs;
+
+    // Parallel method with reduction
+    double total_reduction_time = 0;
+    for (int run = 0; run < num_runs; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        dot_product = 0;
+        #pragma omp parallel for reduction(+:dot_product)
+        for (long long i = 0; i < size; i++) {
+            dot_product += static_cast<long long>(vec1[i]) * vec2[i];
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> reduction_time = end - start;
+        total_reduction_time += reduction_time.count();
+    }
+    double average_reduction_time = total_reduction_time / num_runs;
+
+    // Log results
+    log_file << "Vector size: " << size << std::endl;
+    log_file << "Sequential method time: " << average_sequential_time << " ms" << std::endl;
+    log_file << "Reduction method time: " << average_reduction_time << " ms" << std::endl;
+    log_file << "--------------------------------------" << std::endl;
+}
+
+// ./2 [dataset [sequential]] — без аргументов векторы заполняются константами,
+// иначе vec1 и vec2 — первые две строки файла (см. gen_dataset.cpp).
+int main(int argc, char** argv) {
     std::ofstream log_file("2_log.txt");
     const int num_runs = 5; // Количество запусков для вычисления среднего времени
 
-    for (int size : {1000, 10000, 100000, 1000000, 10000000, 100000000}) {
-        std::vector<int> vec1(size, 1);
-        std::vector<int> vec2(size, 2);
-        int dot_product = 0;
-
-        // Sequential method
-        double total_sequential_time = 0;
-        for (int run = 0; run < num_runs; run++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            dot_product = 0;
-            for (int i = 0; i < size; i++) {
-                dot_product += vec1[i] * vec2[i];
-            }
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double, std::milli> sequential_time = end - start;
-            total_sequential_time += sequential_time.count();
+    if (argc > 1) {
+        auto start = std::chrono::high_resolution_clock::now();
+        DatasetView<int> data = dataset_open<int>(argv[1], dataset_access_from_arg(argc, argv, 2));
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!data.ok()) {
+            return 1;
         }
-        double average_sequential_time = total_sequential_time / num_runs;
-
-        // Parallel method with reduction
-        double total_reduction_time = 0;
-        for (int run = 0; run < num_runs; run++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            dot_product = 0;
-            #pragma omp parallel for reduction(+:dot_product)
-            for (int i = 0; i < size; i++) {
-                dot_product += vec1[i] * vec2[i];
-            }
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double, std::milli> reduction_time = end - start;
-            total_reduction_time += reduction_time.count();
+        if (data.rows < 2) {
+            std::cerr << "Dataset must hold two vectors (rows = 2)" << std::endl;
+            return 1;
         }
-        double average_reduction_time = total_reduction_time / num_runs;
+        log_file << "Dataset: " << argv[1] << std::endl;
+        log_file << "Dataset open time: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+        run_tests(log_file, data[0], data[1], data.cols, num_runs);
+        dataset_close(data);
+        log_file.close();
+        return 0;
+    }
 
-        // Log results
-        log_file << "Vector size: " << size << std::endl;
-        log_file << "Sequential method time: " << average_sequential_time << " ms" << std::endl;
-        log_file << "Reduction method time: " << average_reduction_time << " ms" << std::endl;
-        log_file << "--------------------------------------" << std::endl;
+    for (int size : {1000, 10000, 100000, 1000000, 10000000, 100000000}) {
+        huge_vector<int> vec1(size, 1);
+        huge_vector<int> vec2(size, 2);
+        run_tests(log_file, vec1.data(), vec2.data(), size, num_runs);
     }
 
     log_file.close();
@@ -4,14 +4,17 @@
 #include <limits>
 #include <chrono>
 #include <fstream>
+#include "huge_alloc.h"
+#include "dataset.h"
 
-// Функция для последовательного выполнения
-int max_of_mins_sequential(const std::vector<std::vector<int>>& matrix) {
+// Функция для последовательного выполнения (Matrix — HugeMatrix или DatasetView)
+template <typename Matrix>
+int max_of_mins_sequential(const Matrix& matrix) {
     int max_of_mins = std::numeric_limits<int>::min();
-    for (const auto& row : matrix) {
+    for (int i = 0; i < matrix.rows; i++) {
         int min_in_row = std::numeric_limits<int>::max();
-        for (int val : row) {
-            if (val < min_in_row) min_in_row = val;
+        for (int j = 0; j < matrix.cols; j++) {
+            if (matrix[i][j] < min_in_row) min_in_row = matrix[i][j];
         }
         if (min_in_row > max_of_mins) max_of_mins = min_in_row;
     }
@@ -19,12 +22,13 @@ int max_of_mins_sequential(const std::vector<std::vector<int>>& matrix) {
 }
 
 // Функция для параллельного выполнения с использованием редукции
-int max_of_mins_parallel(const std::vector<std::vector<int>>& matrix) {
+template <typename Matrix>
+int max_of_mins_parallel(const Matrix& matrix) {
     int max_of_mins = std::numeric_limits<int>::min();
     #pragma omp parallel for reduction(max:max_of_mins)
-    for (int i = 0; i < matrix.size(); i++) {
+    for (int i = 0; i < matrix.rows; i++) {
         int min_in_row = std::numeric_limits<int>::max();
-        for (int j = 0; j < matrix[i].size(); j++) {
+        for (int j = 0; j < matrix.cols; j++) {
             if (matrix[i][j] < min_in_row) min_in_row = matrix[i][j];
         }
         if (min_in_row > max_of_mins) max_of_mins = min_in_row;
@@ -32,7 +36,36 @@ int max_of_mins_parallel(const std::vector<std::vector<int>>& matrix) {
     return max_of_mins;
 }
 
-int main() {
+template <typename Matrix>
+void run_tests(std::ofstream& log_file, const Matrix& matrix, int num_tests) {
+    // Sequential method
+    double sequential_time = 0.0;
+    for (int i = 0; i < num_tests; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        max_of_mins_sequential(matrix);
+        auto end = std::chrono::high_resolution_clock::now();
+        sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    sequential_time /= num_tests;
+
+    // Parallel method
+    double parallel_time = 0.0;
+    for (int i = 0; i < num_tests; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        max_of_mins_parallel(matrix);
+        auto end = std::chrono::high_resolution_clock::now();
+        parallel_time += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    parallel_time /= num_tests;
+
+    // Log results
+    log_file << "Sequential method time: " << sequential_time << " ms" << std::endl;
+    log_file << "Parallel method time: " << parallel_time << " ms" << std::endl;
+    log_file << "--------------------------------------" << std::endl;
+}
+
+// ./4 [dataset [sequential]] — без аргументов матрицы генерируются rand().
+int main(int argc, char** argv) {
     std::ofstream log_file("4_log.txt");
     if (!log_file.is_open()) {
         std::cerr << "Failed to open log file!" << std::endl;
@@ -40,41 +73,34 @@ int main() {
     }
 
     const int num_tests = 5;
+
+    if (argc > 1) {
+        auto start = std::chrono::high_resolution_clock::now();
+        DatasetView<int> matrix = dataset_open<int>(argv[1], dataset_access_from_arg(argc, argv, 2));
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!matrix.ok()) {
+            return 1;
+        }
+        log_file << "Dataset: " << argv[1] << " (" << matrix.rows << "x" << matrix.cols << ")" << std::endl;
+        log_file << "Dataset open time: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+        run_tests(log_file, matrix, num_tests);
+        dataset_close(matrix);
+        log_file.close();
+        return 0;
+    }
+
     for (int size : {100, 1000, 10000}) {
-        std::vector<std::vector<int>> matrix(size, std::vector<int>(size));
+        HugeMatrix<int> matrix(size, size);
         for (int i = 0; i < size; i++) {
             for (int j = 0; j < size; j++) {
                 matrix[i][j] = rand() % 1000;
             }
         }
 
-        // Sequential method
-        double sequential_time = 0.0;
-        for (int i = 0; i < num_tests; i++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            max_of_mins_sequential(matrix);
-            auto end = std::chrono::high_resolution_clock::now();
-            sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        sequential_time /= num_tests;
-
-        // Parallel method
-        double parallel_time = 0.0;
-        for (int i = 0; i < num_tests; i++) {
-            auto start = std::chrono::high_resolution_clock::now();
-            max_of_mins_parallel(matrix);
-            auto end = std::chrono::high_resolution_clock::now();
-            parallel_time += std::chrono::duration<double, std::milli>(end - start).count();
-        }
-        parallel_time /= num_tests;
-
-        // Log results
         log_file << "Matrix size: " << size << std::endl;
-        log_file << "Sequential method time: " << sequential_time << " ms" << std::endl;
-        log_file << "Parallel method time: " << parallel_time << " ms" << std::endl;
-        log_file << "--------------------------------------" << std::endl;
+        run_tests(log_file, matrix, num_tests);
     }
 
     log_file.close();
     return 0;
-}
\ No newline at end of file
+}
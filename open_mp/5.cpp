@@ -4,10 +4,12 @@
 #include <omp.h>
 #include <chrono>
 #include <fstream>
+#include "huge_alloc.h"
+#include "dataset.h"
 
 // Генерация ленточной матрицы
-std::vector<std::vector<int>> generate_band_matrix(int size, int bandwidth) {
-    std::vector<std::vector<int>> matrix(size, std::vector<int>(size, 0));
+HugeMatrix<int> generate_band_matrix(int size, int bandwidth) {
+    HugeMatrix<int> matrix(size, size, 0);
     for (int i = 0; i < size; i++) {
         for (int j = std::max(0, i - bandwidth); j <= std::min(size - 1, i + bandwidth); j++) {
             matrix[i][j] = rand() % 100;
@@ -17,8 +19,8 @@ std::vector<std::vector<int>> generate_band_matrix(int size, int bandwidth) {
 }
 
 // Генерация нижнетреугольной матрицы
-std::vector<std::vector<int>> generate_lower_triangular_matrix(int size) {
-    std::vector<std::vector<int>> matrix(size, std::vector<int>(size, 0));
+HugeMatrix<int> generate_lower_triangular_matrix(int size) {
+    HugeMatrix<int> matrix(size, size, 0);
     for (int i = 0; i < size; i++) {
         for (int j = 0; j <= i; j++) {
             matrix[i][j] = rand() % 100;
@@ -27,15 +29,17 @@ std::vector<std::vector<int>> generate_lower_triangular_matrix(int size) {
     return matrix;
 }
 
-// Функция для поиска максимума среди минимумов строк матрицы (параллельная)
-int max_of_row_mins_parallel(const std::vector<std::vector<int>>& matrix, const std::string& schedule_type) {
+// Функция для поиска максимума среди минимумов строк матрицы (параллельная);
+// Matrix — HugeMatrix или DatasetView
+template <typename Matrix>
+int max_of_row_mins_parallel(const Matrix& matrix, const std::string& schedule_type) {
     int max_of_mins = std::numeric_limits<int>::min();
 
     // Параллельная секция с выбором типа распределения итераций
     #pragma omp parallel for schedule(runtime) reduction(max:max_of_mins)
-    for (int i = 0; i < matrix.size(); i++) {
+    for (int i = 0; i < matrix.rows; i++) {
         int min_in_row = std::numeric_limits<int>::max();
-        for (int j = 0; j < matrix[i].size(); j++) {
+        for (int j = 0; j < matrix.cols; j++) {
             if (matrix[i][j] < min_in_row) {
                 min_in_row = matrix[i][j];
             }
@@ -48,13 +52,14 @@ int max_of_row_mins_parallel(const std::vector<std::vector<int>>& matrix, const
 }
 
 // Функция для поиска максимума среди минимумов строк матрицы (последовательная)
-int max_of_row_mins_sequential(const std::vector<std::vector<int>>& matrix) {
+template <typename Matrix>
+int max_of_row_mins_sequential(const Matrix& matrix) {
     int max_of_mins = std::numeric_limits<int>::min();
-    for (const auto& row : matrix) {
+    for (int i = 0; i < matrix.rows; i++) {
         int min_in_row = std::numeric_limits<int>::max();
-        for (int val : row) {
-            if (val < min_in_row) {
-                min_in_row = val;
+        for (int j = 0; j < matrix.cols; j++) {
+            if (matrix[i][j] < min_in_row) {
+                min_in_row = matrix[i][j];
             }
         }
         if (min_in_row > max_of_mins) {
@@ -64,7 +69,40 @@ int max_of_row_mins_sequential(const std::vector<std::vector<int>>& matrix) {
     return max_of_mins;
 }
 
-int main() {
+// Замер всех типов распределения на одной матрице
+template <typename Matrix>
+void run_schedules(std::ofstream& log_file, const Matrix& matrix, const std::vector<std::string>& schedules, int num_tests) {
+    for (const auto& schedule : schedules) {
+        omp_set_schedule(omp_sched_t::omp_sched_static, 0); // Выбор типа распределения
+
+        double parallel_time = 0.0;
+        double sequential_time = 0.0;
+
+        for (int i = 0; i < num_tests; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            max_of_row_mins_parallel(matrix, schedule);
+            auto end = std::chrono::high_resolution_clock::now();
+            parallel_time += std::chrono::duration<double, std::milli>(end - start).count();
+
+            start = std::chrono::high_resolution_clock::now();
+            max_of_row_mins_sequential(matrix);
+            end = std::chrono::high_resolution_clock::now();
+            sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        parallel_time /= num_tests;
+        sequential_time /= num_tests;
+
+        log_file << "Schedule: " << schedule << "\n";
+        log_file << "Sequential method time: " << sequential_time << " ms\n";
+        log_file << "Parallel method time: " << parallel_time << " ms\n";
+        log_file << "--------------------------------------\n";
+    }
+}
+
+// ./5 [dataset [sequential]] — без аргументов ленточная и нижнетреугольная
+// матрицы генерируются rand(), иначе замеры идут на матрице из файла.
+int main(int argc, char** argv) {
     std::ofstream log_file("5_log.txt");
     if (!log_file.is_open()) {
         std::cerr << "Failed to open log file!" << std::endl;
@@ -78,6 +116,22 @@ int main() {
     // Массив типов распределения
     std::vector<std::string> schedules = {"static", "dynamic", "guided"};
 
+    if (argc > 1) {
+        auto start = std::chrono::high_resolution_clock::now();
+        DatasetView<int> matrix = dataset_open<int>(argv[1], dataset_access_from_arg(argc, argv, 2));
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!matrix.ok()) {
+            return 1;
+        }
+        log_file << "Dataset: " << argv[1] << " (" << matrix.rows << "x" << matrix.cols << ")\n";
+        log_file << "Dataset open time: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+        log_file << "\nDataset matrix results:\n";
+        run_schedules(log_file, matrix, schedules, num_tests);
+        dataset_close(matrix);
+        log_file.close();
+        return 0;
+    }
+
     for (int size : sizes) {
         // Генерация матриц
         auto band_matrix = generate_band_matrix(size, bandwidth);
@@ -85,61 +139,11 @@ int main() {
 
         // Тестирование для ленточной матрицы
         log_file << "\nBand matrix results for size " << size << ":\n";
-        for (const auto& schedule : schedules) {
-            omp_set_schedule(omp_sched_t::omp_sched_static, 0); // Выбор типа распределения
-
-            double parallel_time = 0.0;
-            double sequential_time = 0.0;
-
-            for (int i = 0; i < num_tests; i++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                max_of_row_mins_parallel(band_matrix, schedule);
-                auto end = std::chrono::high_resolution_clock::now();
-                parallel_time += std::chrono::duration<double, std::milli>(end - start).count();
-
-                start = std::chrono::high_resolution_clock::now();
-                max_of_row_mins_sequential(band_matrix);
-                end = std::chrono::high_resolution_clock::now();
-                sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-
-            parallel_time /= num_tests;
-            sequential_time /= num_tests;
-
-            log_file << "Schedule: " << schedule << "\n";
-            log_file << "Sequential method time: " << sequential_time << " ms\n";
-            log_file << "Parallel method time: " << parallel_time << " ms\n";
-            log_file << "--------------------------------------\n";
-        }
+        run_schedules(log_file, band_matrix, schedules, num_tests);
 
         // Тестирование для нижнетреугольной матрицы
         log_file << "\nLower triangular matrix results for size " << size << ":\n";
-        for (const auto& schedule : schedules) {
-            omp_set_schedule(omp_sched_t::omp_sched_static, 0); // Выбор типа распределения
-
-            double parallel_time = 0.0;
-            double sequential_time = 0.0;
-
-            for (int i = 0; i < num_tests; i++) {
-                auto start = std::chrono::high_resolution_clock::now();
-                max_of_row_mins_parallel(lower_triangular_matrix, schedule);
-                auto end = std::chrono::high_resolution_clock::now();
-                parallel_time += std::chrono::duration<double, std::milli>(end - start).count();
-
-                start = std::chrono::high_resolution_clock::now();
-                max_of_row_mins_sequential(lower_triangular_matrix);
-                end = std::chrono::high_resolution_clock::now();
-                sequential_time += std::chrono::duration<double, std::milli>(end - start).count();
-            }
-
-            parallel_time /= num_tests;
-            sequential_time /= num_tests;
-
-            log_file << "Schedule: " << schedule << "\n";
-            log_file << "Sequential method time: " << sequential_time << " ms\n";
-            log_file << "Parallel method time: " << parallel_time << " ms\n";
-            log_file << "--------------------------------------\n";
-        }
+        run_schedules(log_file, lower_triangular_matrix, schedules, num_tests);
     }
 
     log_file.close();
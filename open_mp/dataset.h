@@ -0,0 +1,189 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Двоичный формат входных данных: заголовок DatasetHeader, затем с отступа
+// data_offset (кратен 4 КБ) — rows строк по stride элементов, из которых
+// значимы первые cols. stride выбирается так, чтобы каждая строка начиналась
+// с границы 64 байт. Вектор хранится как одна строка, пара векторов — как две.
+//
+// dataset_open отображает файл через mmap и возвращает DatasetView,
+// указывающий прямо в отображение, без копирования. Страницы либо читаются
+// сразу (MAP_POPULATE), либо подгружаются по мере чтения с подсказкой
+// MADV_SEQUENTIAL для упреждающего чтения.
+
+const char dataset_magic[8] = {'O', 'M', 'P', 'D', 'A', 'T', 'A', '\0'};
+const uint32_t dataset_version = 1;
+const size_t dataset_data_offset = 4096;
+const size_t dataset_row_align = 64;
+
+enum DatasetType : uint32_t { DATASET_INT32 = 1, DATASET_FLOAT32 = 2, DATASET_FLOAT64 = 3 };
+
+template <typename T> struct dataset_type_of;
+template <> struct dataset_type_of<int> { static const uint32_t value = DATASET_INT32; };
+template <> struct dataset_type_of<float> { static const uint32_t value = DATASET_FLOAT32; };
+template <> struct dataset_type_of<double> { static const uint32_t value = DATASET_FLOAT64; };
+
+struct DatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t type;        // DatasetType
+    uint32_t elem_size;   // байт на элемент
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stride;      // элементов между началами соседних строк
+    uint64_t data_offset; // байт от начала файла до первой строки
+};
+
+enum DatasetAccess { DATASET_POPULATE, DATASET_SEQUENTIAL };
+
+template <typename T>
+size_t dataset_stride(size_t cols) {
+    size_t per_line = dataset_row_align / sizeof(T);
+    return (cols + per_line - 1) / per_line * per_line;
+}
+
+// Пишет rows x cols; fill_row(i, row) заполняет строку i (cols элементов).
+// Строки генерируются по одной, так что файл может быть больше памяти.
+template <typename T>
+bool dataset_write(const std::string& path, size_t rows, size_t cols,
+                   const std::function<void(size_t, T*)>& fill_row) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Cannot create dataset " << path << std::endl;
+        return false;
+    }
+    DatasetHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, dataset_magic, sizeof(header.magic));
+    header.version = dataset_version;
+    header.type = dataset_type_of<T>::value;
+    header.elem_size = sizeof(T);
+    header.rows = rows;
+    header.cols = cols;
+    header.stride = dataset_stride<T>(cols);
+    header.data_offset = dataset_data_offset;
+
+    std::vector<char> head(dataset_data_offset, 0);
+    std::memcpy(head.data(), &header, sizeof(header));
+    bool ok = std::fwrite(head.data(), 1, head.size(), f) == head.size();
+
+    std::vector<T> row(header.stride, T());
+    for (size_t i = 0; ok && i < rows; i++) {
+        fill_row(i, row.data());
+        ok = std::fwrite(row.data(), sizeof(T), row.size(), f) == row.size();
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write dataset " << path << std::endl;
+    }
+    return ok;
+}
+
+template <typename T>
+bool dataset_write(const std::string& path, const T* data, size_t rows, size_t cols) {
+    return dataset_write<T>(path, rows, cols, [&](size_t i, T* row) {
+        std::memcpy(row, data + i * cols, cols * sizeof(T));
+    });
+}
+
+// Строки читаются как matrix[i][j], как у HugeMatrix и vector<vector<T>>.
+template <typename T>
+struct DatasetView {
+    const T* data = nullptr;
+    long long rows = 0;
+    long long cols = 0;
+    long long stride = 0;
+    void* map = nullptr;
+    size_t map_length = 0;
+
+    bool ok() const { return data != nullptr; }
+    const T* operator[](long long i) const { return data + i * stride; }
+    long long size() const { return rows; }
+};
+
+// Читает и проверяет заголовок открытого файла; в length — сколько байт
+// файла занимают заголовок и данные.
+template <typename T>
+bool dataset_read_header(const std::string& path, int fd, DatasetHeader& header, size_t& length) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        std::memcmp(header.magic, dataset_magic, sizeof(header.magic)) != 0 || header.version != dataset_version) {
+        std::cerr << path << " is not a dataset file" << std::endl;
+        return false;
+    }
+    if (header.type != dataset_type_of<T>::value || header.elem_size != sizeof(T)) {
+        std::cerr << path << " holds a different element type" << std::endl;
+        return false;
+    }
+    length = header.data_offset + header.rows * header.stride * sizeof(T);
+    if (header.stride < header.cols || static_cast<size_t>(st.st_size) < length) {
+        std::cerr << path << " is truncated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+DatasetView<T> dataset_open(const std::string& path, DatasetAccess access = DATASET_POPULATE) {
+    DatasetView<T> view;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open dataset " << path << std::endl;
+        return view;
+    }
+    DatasetHeader header;
+    size_t length;
+    if (!dataset_read_header<T>(path, fd, header, length)) {
+        close(fd);
+        return view;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (access == DATASET_POPULATE) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* map = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "Cannot map dataset " << path << std::endl;
+        return view;
+    }
+    if (access == DATASET_SEQUENTIAL) {
+        madvise(map, length, MADV_SEQUENTIAL);
+    }
+
+    view.data = reinterpret_cast<const T*>(static_cast<const char*>(map) + header.data_offset);
+    view.rows = static_cast<long long>(header.rows);
+    view.cols = static_cast<long long>(header.cols);
+    view.stride = static_cast<long long>(header.stride);
+    view.map = map;
+    view.map_length = length;
+    return view;
+}
+
+template <typename T>
+void dataset_close(DatasetView<T>& view) {
+    if (view.map != nullptr) {
+        munmap(view.map, view.map_length);
+    }
+    view = DatasetView<T>();
+}
+
+// "sequential" в командной строке выбирает ленивую подгрузку, иначе MAP_POPULATE.
+inline DatasetAccess dataset_access_from_arg(int argc, char** argv, int index) {
+    return argc > index && std::string(argv[index]) == "sequential" ? DATASET_SEQUENTIAL : DATASET_POPULATE;
+}
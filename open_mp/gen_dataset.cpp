@@ -0,0 +1,36 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include "dataset.h"
+
+// Генерация входных файлов для 1, 2, 4 и 5.cpp:
+//   ./gen_dataset <file> <rows> <cols> [max_value] [seed]
+// 1.cpp читает вектор (rows = 1), 2.cpp — пару векторов (rows = 2),
+// 4.cpp и 5.cpp — матрицу rows x cols. Значения — rand() % max_value.
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <file> <rows> <cols> [max_value] [seed]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    size_t rows = std::strtoull(argv[2], nullptr, 10);
+    size_t cols = std::strtoull(argv[3], nullptr, 10);
+    int max_value = argc > 4 ? std::atoi(argv[4]) : 1000;
+    unsigned seed = argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : 1;
+    if (rows == 0 || cols == 0 || max_value <= 0) {
+        std::cerr << "rows, cols and max_value must be positive" << std::endl;
+        return 1;
+    }
+
+    srand(seed);
+    bool ok = dataset_write<int>(path, rows, cols, [&](size_t, int* row) {
+        for (size_t j = 0; j < cols; j++) {
+            row[j] = rand() % max_value;
+        }
+    });
+    if (!ok) {
+        return 1;
+    }
+    std::cout << "Written " << rows << "x" << cols << " ints to " << path << std::endl;
+    return 0;
+}
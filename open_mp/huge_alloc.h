@@ -0,0 +1,175 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Выделение памяти под большие массивы страницами по 2 МБ.
+// Блоки берутся через mmap, поэтому всегда выровнены минимум на 4 КБ
+// (а значит и на 64 байта — границу кэш-линии). Блоки от 2 МБ выравниваются
+// на 2 МБ, чтобы ядро могло отобразить их целыми huge-страницами.
+//
+// Режимы:
+//   PAGES_SMALL   — обычные 4 КБ страницы (MADV_NOHUGEPAGE), для сравнения;
+//   PAGES_THP     — transparent huge pages через madvise(MADV_HUGEPAGE);
+//   PAGES_HUGETLB — MAP_HUGETLB из пула /proc/sys/vm/nr_hugepages.
+// Если HUGETLB-страниц нет, выделение откатывается к THP, а THP без поддержки
+// ядра просто остаётся на обычных страницах.
+
+enum PageMode { PAGES_SMALL, PAGES_THP, PAGES_HUGETLB };
+
+const size_t huge_page_size = 2 * 1024 * 1024;
+const size_t small_page_size = 4096;
+
+inline const char* page_mode_name(PageMode mode) {
+    switch (mode) {
+        case PAGES_SMALL: return "4k";
+        case PAGES_THP: return "thp";
+        case PAGES_HUGETLB: return "hugetlb";
+    }
+    return "?";
+}
+
+// Длина отображения для блока из bytes байт; по ней же блок и освобождается.
+inline size_t huge_mapping_length(size_t bytes) {
+    size_t page = bytes >= huge_page_size ? huge_page_size : small_page_size;
+    return (bytes + page - 1) / page * page;
+}
+
+// Выделяет bytes байт; в obtained (если не nullptr) пишется режим,
+// который удалось получить. Возвращает nullptr при нехватке памяти.
+inline void* huge_alloc(size_t bytes, PageMode mode, PageMode* obtained = nullptr) {
+    size_t length = huge_mapping_length(bytes == 0 ? 1 : bytes);
+    bool huge = length >= huge_page_size;
+
+#ifdef MAP_HUGETLB
+    if (mode == PAGES_HUGETLB && huge) {
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            if (obtained) *obtained = PAGES_HUGETLB;
+            return p;
+        }
+        mode = PAGES_THP;
+    }
+#endif
+
+    // С запасом в одну huge-страницу, лишнее по краям сразу отдаётся обратно.
+    size_t reserve = huge ? length + huge_page_size : length;
+    void* raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    char* p = static_cast<char*>(raw);
+    if (huge) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+        char* aligned = p + (huge_page_size - addr % huge_page_size) % huge_page_size;
+        if (aligned > p) {
+            munmap(p, aligned - p);
+        }
+        size_t tail = (p + reserve) - (aligned + length);
+        if (tail > 0) {
+            munmap(aligned + length, tail);
+        }
+        p = aligned;
+    }
+
+    PageMode got = PAGES_SMALL;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if (huge && mode != PAGES_SMALL) {
+        if (madvise(p, length, MADV_HUGEPAGE) == 0) {
+            got = PAGES_THP;
+        }
+    } else if (huge) {
+        madvise(p, length, MADV_NOHUGEPAGE);
+    }
+#endif
+    if (obtained) *obtained = got;
+    return p;
+}
+
+inline void huge_free(void* p, size_t bytes) {
+    if (p != nullptr) {
+        munmap(p, huge_mapping_length(bytes == 0 ? 1 : bytes));
+    }
+}
+
+// Сколько КБ блока [p, p + bytes) сейчас действительно лежит на huge-страницах
+// (по /proc/self/smaps). Блок должен быть уже заполнен.
+inline long huge_backed_kb(const void* p, size_t bytes) {
+    FILE* f = std::fopen("/proc/self/smaps", "r");
+    if (!f) {
+        return -1;
+    }
+    uintptr_t lo = reinterpret_cast<uintptr_t>(p), hi = lo + bytes;
+    char line[256];
+    bool inside = false;
+    long total = 0;
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start < hi && end > lo;
+            continue;
+        }
+        long kb;
+        if (inside && (std::sscanf(line, "AnonHugePages: %ld kB", &kb) == 1 ||
+                       std::sscanf(line, "Private_Hugetlb: %ld kB", &kb) == 1)) {
+            total += kb;
+        }
+    }
+    std::fclose(f);
+    return total;
+}
+
+// Аллокатор для std::vector поверх huge_alloc. Освобождение зависит только от
+// размера, поэтому все экземпляры взаимозаменяемы.
+template <typename T>
+class HugePageAllocator {
+public:
+    typedef T value_type;
+
+    HugePageAllocator(PageMode mode = PAGES_THP) : mode(mode) {}
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>& other) : mode(other.mode) {}
+
+    T* allocate(size_t n) {
+        void* p = huge_alloc(n * sizeof(T), mode);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) {
+        huge_free(p, n * sizeof(T));
+    }
+
+    PageMode mode;
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+template <typename T>
+using huge_vector = std::vector<T, HugePageAllocator<T>>;
+
+// Матрица rows x cols одним непрерывным блоком; matrix[i][j] как у
+// vector<vector<T>>, но строки идут подряд и лежат на общих huge-страницах.
+template <typename T>
+struct HugeMatrix {
+    HugeMatrix(int rows, int cols, T value = T(), PageMode mode = PAGES_THP)
+        : rows(rows), cols(cols), data(static_cast<size_t>(rows) * cols, value, HugePageAllocator<T>(mode)) {}
+
+    T* operator[](int i) { return data.data() + static_cast<size_t>(i) * cols; }
+    const T* operator[](int i) const { return data.data() + static_cast<size_t>(i) * cols; }
+    int size() const { return rows; }
+
+    int rows;
+    int cols;
+    huge_vector<T> data;
+};